@@ -0,0 +1,11 @@
+/** @file adc.h
+*
+* @brief    The host stand-in for the CubeMX generated adc.h
+*/
+
+#ifndef _adc_H
+#define _adc_H
+
+#include "halHost.h"
+
+#endif /* _adc_H */
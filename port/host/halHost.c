@@ -0,0 +1,99 @@
+/** @file halHost.c
+*
+* @brief    A stand-in for the parts of the STM32 HAL the weather meter
+*           library uses, so it builds and runs on a host
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "halHost.h"
+#include <stddef.h>
+
+/**
+ * @brief   The host tick, moved on by the simulator
+ */
+static volatile uint32_t _tick = 0;
+
+uint32_t HAL_GetTick( void )
+{
+    return _tick;
+}
+
+void halHostSetTick( uint32_t tick )
+{
+    _tick = tick;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA( ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length )
+{
+    if( ( hadc == NULL ) || ( pData == NULL ) || ( Length == 0 ) )
+    {
+        return HAL_ERROR;
+    }
+    hadc->DmaBuffer = pData;
+    hadc->DmaLength = Length;
+    hadc->Running = 1;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start( TIM_HandleTypeDef *htim )
+{
+    if( ( htim == NULL ) || ( htim->Instance == NULL ) )
+    {
+        return HAL_ERROR;
+    }
+    htim->Running = 1;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Start_DMA( TIM_HandleTypeDef *htim, uint32_t Channel,
+                                        uint32_t *pData, uint16_t Length )
+{
+    DMA_HandleTypeDef *hdma;
+
+    if( ( htim == NULL ) || ( pData == NULL ) || ( Length == 0 ) || ( Channel > TIM_CHANNEL_4 ) )
+    {
+        return HAL_ERROR;
+    }
+    hdma = htim->hdma[TIM_DMA_ID_CC1 + ( Channel >> 2 )];
+    if( ( hdma == NULL ) || ( hdma->Instance == NULL ) )
+    {
+        return HAL_ERROR;
+    }
+    hdma->Buffer = pData;
+    hdma->Length = Length;
+    hdma->Instance->CNDTR = Length;
+    htim->Running = 1;
+    return HAL_OK;
+}
+
+__weak void HAL_ADC_ConvHalfCpltCallback( ADC_HandleTypeDef *hadc )
+{
+    (void)hadc;
+}
+
+__weak void HAL_ADC_ConvCpltCallback( ADC_HandleTypeDef *hadc )
+{
+    (void)hadc;
+}
+
+__weak void HAL_GPIO_EXTI_Callback( uint16_t GPIO_Pin )
+{
+    (void)GPIO_Pin;
+}
+
+// End of file - halHost.c
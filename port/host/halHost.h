@@ -0,0 +1,159 @@
+/** @file halHost.h
+*
+* @brief    A stand-in for the parts of the STM32 HAL the weather meter
+*           library uses, so it builds and runs on a host.  The handles
+*           keep what the DMA and timers would be doing for the simulator
+*           (weatherMeterSim.h) to play with
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef _halHost_H
+#define _halHost_H
+
+#include <stdint.h>
+
+#ifndef __weak
+#define __weak __attribute__( ( weak ) )
+#endif
+
+/**
+ * @brief   HAL function status
+ */
+typedef enum
+{
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+/**
+ * @brief   A DMA channel, CNDTR counts down the transfers left before the
+ *          circular buffer wraps
+ */
+typedef struct
+{
+    volatile uint32_t CNDTR;
+} DMA_Channel_TypeDef;
+
+/**
+ * @brief   A DMA handle.  Buffer and Length are host only, the buffer the
+ *          channel was started on
+ */
+typedef struct
+{
+    DMA_Channel_TypeDef *Instance;
+    void *Buffer;
+    uint32_t Length;
+} DMA_HandleTypeDef;
+
+#define __HAL_DMA_GET_COUNTER( h ) ( ( h )->Instance->CNDTR )
+
+/**
+ * @brief   A timer, only the counter and its update flag are modelled
+ */
+typedef struct
+{
+    volatile uint32_t SR;
+    volatile uint32_t CNT;
+    volatile uint32_t ARR;
+} TIM_TypeDef;
+
+#define TIM_SR_UIF          0x00000001U
+#define TIM_FLAG_UPDATE     TIM_SR_UIF
+
+#define __HAL_TIM_GET_FLAG( h, f )      ( ( ( h )->Instance->SR & ( f ) ) == ( f ) )
+#define __HAL_TIM_CLEAR_FLAG( h, f )    ( ( h )->Instance->SR &= ~( f ) )
+
+/**
+ * @brief   A timer handle.  Running is host only, set once the timer is
+ *          started
+ */
+typedef struct
+{
+    TIM_TypeDef *Instance;
+    DMA_HandleTypeDef *hdma[7];
+    uint8_t Running;
+} TIM_HandleTypeDef;
+
+#define TIM_DMA_ID_UPDATE   ( (uint16_t)0x0000 )
+#define TIM_DMA_ID_CC1      ( (uint16_t)0x0001 )
+#define TIM_DMA_ID_CC2      ( (uint16_t)0x0002 )
+#define TIM_DMA_ID_CC3      ( (uint16_t)0x0003 )
+#define TIM_DMA_ID_CC4      ( (uint16_t)0x0004 )
+
+#define TIM_CHANNEL_1       0x00000000U
+#define TIM_CHANNEL_2       0x00000004U
+#define TIM_CHANNEL_3       0x00000008U
+#define TIM_CHANNEL_4       0x0000000CU
+
+/**
+ * @brief   An ADC, nothing of it is modelled
+ */
+typedef struct
+{
+    uint32_t reserved;
+} ADC_TypeDef;
+
+/**
+ * @brief   An ADC handle.  DmaBuffer, DmaLength and Running are host only,
+ *          the circular buffer the conversions go to
+ */
+typedef struct
+{
+    ADC_TypeDef *Instance;
+    uint32_t *DmaBuffer;
+    uint32_t DmaLength;
+    uint8_t Running;
+} ADC_HandleTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Returns the host tick, in milliseconds
+ * @param   None
+ * @retval  The tick
+ */
+uint32_t HAL_GetTick( void );
+/**
+ * @brief   Sets the host tick, for the simulator
+ * @param   tick - The new tick
+ * @retval  None
+ */
+void halHostSetTick( uint32_t tick );
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA( ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length );
+HAL_StatusTypeDef HAL_TIM_Base_Start( TIM_HandleTypeDef *htim );
+HAL_StatusTypeDef HAL_TIM_IC_Start_DMA( TIM_HandleTypeDef *htim, uint32_t Channel,
+                                        uint32_t *pData, uint16_t Length );
+
+/*
+ * Called by the simulator like the HAL would from its interrupts.  Empty
+ * weak versions are provided, define them to use them
+ */
+void HAL_ADC_ConvHalfCpltCallback( ADC_HandleTypeDef *hadc );
+void HAL_ADC_ConvCpltCallback( ADC_HandleTypeDef *hadc );
+void HAL_GPIO_EXTI_Callback( uint16_t GPIO_Pin );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _halHost_H */
@@ -0,0 +1,86 @@
+/** @file testAutoCal.c
+*
+* @brief    Checks self calibration follows a wind vane drifting off its
+*           value, and stops at WIND_VANE_AUTOCAL_MAX_DRIFT
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+#if !WIND_VANE_AUTOCAL
+#error "testAutoCal needs WIND_VANE_AUTOCAL"
+#endif
+
+/**
+ * @brief   TEST_STEP - ADC codes the vane drifts by per segment
+ */
+#define TEST_STEP 5
+/**
+ * @brief   TEST_STEPS - segments of the drift, 4 bands in all
+ */
+#define TEST_STEPS ( 4 * WIND_VANE_CODE_BAND / TEST_STEP )
+/**
+ * @brief   TEST_STEP_MS - the length of a segment
+ */
+#define TEST_STEP_MS 10000
+
+static weatherSimSegment_t _drift[TEST_STEPS + 2];
+static weatherSim_t _sim;
+
+int main( void )
+{
+    const uint32_t start = WIND_VANE_VALUES[N];
+    uint32_t i;
+
+    // N drifts down, away from its neighbours, then past the most the
+    // values may move
+    for( i=0; i<=TEST_STEPS; i++ )
+    {
+        _drift[i].ms = TEST_STEP_MS;
+        _drift[i].direction = N;
+        _drift[i].offset = (int16_t)( -(int32_t)( i * TEST_STEP ) );
+        _drift[i].noise = 8;
+    }
+    _drift[TEST_STEPS + 1] = _drift[TEST_STEPS];
+    _drift[TEST_STEPS + 1].offset = -( WIND_VANE_AUTOCAL_MAX_DRIFT + 2 * WIND_VANE_CODE_BAND );
+
+    testStart( &_sim, _drift, TEST_STEPS + 2 );
+    for( i=0; i<=TEST_STEPS; i++ )
+    {
+        testPlay( &_sim, TEST_STEP_MS, 0, 0 );
+        // Still read as N, the value a step behind at most
+        TEST_CHECK( getWindVaneDirection() == N );
+        TEST_NEAR( getWindVaneValues()[N], start - i * TEST_STEP, TEST_STEP );
+    }
+    // Every other value stayed where it was
+    for( i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
+    {
+        if( i != N )
+        {
+            TEST_CHECK( getWindVaneValues()[i] == WIND_VANE_VALUES[i] );
+        }
+    }
+
+    testPlay( &_sim, TEST_STEP_MS, 0, 0 );
+    TEST_CHECK( getWindVaneValues()[N] >= start - WIND_VANE_AUTOCAL_MAX_DRIFT );
+    TEST_CHECK( getWindVaneDirection() == WIND_VANE_DIRECTIONS_COUNT );
+
+    return testDone();
+}
+
+// End of file - testAutoCal.c
@@ -0,0 +1,141 @@
+/** @file testCadence.c
+*
+* @brief    Checks the wind speed and rain rate stay right when the
+*           process functions are called late, early or batched, on the
+*           millisecond tick and on a faster clock, and that no pulse or
+*           tip is lost or counted twice across the calls
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+/**
+ * @brief   TEST_WIND_CMPH - about 16.09 pulses a second, so no interval
+ *          holds a whole number of them
+ */
+#define TEST_WIND_CMPH 2400
+/**
+ * @brief   TEST_RAIN - a tip every 6 seconds
+ */
+#define TEST_RAIN ( 600 * RAIN_BUCKET_MILLI_INCH )
+
+static const weatherSimSegment_t _trace[] =
+{
+    //  ms          direction   offset  noise   cMPH            milli-in/hr
+    {  4000000,     N,               0,     0, TEST_WIND_CMPH, TEST_RAIN },
+};
+
+/**
+ * @brief   Milliseconds between processWindSpeed() calls: on time, late,
+ *          early, and batched after a stall
+ */
+static const uint32_t _windMs[] =
+{
+    1000, 1000, 1370, 650, 4000, 250, 1000, 10000, 1, 1, 1000, 30000, 2, 998, 5000
+};
+
+/**
+ * @brief   Milliseconds between processRainBucket() calls
+ */
+static const uint32_t _rainMs[] =
+{
+    60000, 60000, 95000, 25000, 300000, 1, 60000, 600000, 60000
+};
+
+static weatherSim_t _sim;
+
+/**
+ * @brief   A 1 MHz clock, on the simulated time
+ * @param   None
+ * @retval  The clock
+ */
+static uint32_t _microseconds( void )
+{
+    return (uint32_t)( _sim.ms * 1000 );
+}
+
+/**
+ * @brief   Plays the wind calls, checking each speed is within a pulse
+ *          over its interval and every pulse is counted once
+ * @param   None
+ * @retval  None
+ */
+static void _testWind( void )
+{
+    const double hz = TEST_WIND_CMPH * 10.0 / WIND_SPEED_MILLI_MPH;
+    uint64_t start = _sim.ms;
+    uint32_t pulses = 0;
+    size_t i;
+
+    for( i=0; i<sizeof( _windMs ) / sizeof( _windMs[0] ); i++ )
+    {
+        testPlay( &_sim, _windMs[i], 0, 0 );
+        processWindSpeed();
+        pulses += getWindSpeedCount();
+        if( _windMs[i] >= 250 )
+        {   // Shorter ones have too few pulses to say much
+            TEST_NEAR( getWindSpeed_cMPH(), TEST_WIND_CMPH, WIND_SPEED_MILLI_MPH * 100.0 / _windMs[i] + 1 );
+        }
+    }
+    TEST_NEAR( pulses, hz * (double)( _sim.ms - start ) / 1000.0, 1 );
+}
+
+/**
+ * @brief   Plays the rain calls, checking each rate is within a tip over
+ *          its interval and every tip is counted once
+ * @param   None
+ * @retval  None
+ */
+static void _testRain( void )
+{
+    uint64_t start = _sim.ms;
+    uint32_t tips = 0;
+    size_t i;
+
+    for( i=0; i<sizeof( _rainMs ) / sizeof( _rainMs[0] ); i++ )
+    {
+        testPlay( &_sim, _rainMs[i], 0, 0 );
+        processRainBucket();
+        // The rate is rounded finer than a tip over any of the intervals
+        tips += (uint32_t)( (double)getRainfall_milliInPerHr() * _rainMs[i] /
+                            ( RAIN_BUCKET_MILLI_INCH * 3600000.0 ) + 0.5 );
+        if( _rainMs[i] >= 25000 )
+        {
+            TEST_NEAR( getRainfall_milliInPerHr(), TEST_RAIN, RAIN_BUCKET_MILLI_INCH * 3600000.0 / _rainMs[i] + 1 );
+        }
+    }
+    TEST_NEAR( tips, (double)( _sim.ms - start ) / 6000.0, 1 );
+}
+
+int main( void )
+{
+    testStart( &_sim, _trace, 1 );
+    _testWind();
+    _testRain();
+
+    // The same on a clock a thousand times finer, restarted in step
+    processWindSpeed();
+    processRainBucket();
+    TEST_CHECK( setWeatherMeterClock( _microseconds, 1000000 ) == 0 );
+    _testWind();
+    _testRain();
+
+    return testDone();
+}
+
+// End of file - testCadence.c
@@ -0,0 +1,94 @@
+/** @file testCapture.c
+*
+* @brief    Checks the wind speed from the pulse period: exact at a steady
+*           rate, within a few hundredths of a MPH in a squall lapping the
+*           capture ring every call, with each lap counted, and calm once
+*           the pulses stop
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+#if !WIND_SPEED_CAPTURE || !WEATHER_METER_HEALTH
+#error "testCapture needs WIND_SPEED_CAPTURE and WEATHER_METER_HEALTH"
+#endif
+
+/**
+ * @brief   TEST_SQUALL_CMPH - about 67 pulses a second, twice what the
+ *          capture ring holds
+ */
+#define TEST_SQUALL_CMPH 10000
+/**
+ * @brief   TEST_SEGMENT_MS - the length of each part of the trace
+ */
+#define TEST_SEGMENT_MS 20000
+
+static const weatherSimSegment_t _trace[] =
+{
+    //  ms              direction   offset  noise   cMPH                milli-in/hr
+    {  TEST_SEGMENT_MS, N,               0,     0, WIND_SPEED_MILLI_MPH,    0 },
+    {  TEST_SEGMENT_MS, N,               0,     0, TEST_SQUALL_CMPH,        0 },
+    {  TEST_SEGMENT_MS, N,               0,     0, 0,                       0 },
+};
+
+static weatherSim_t _sim;
+
+int main( void )
+{
+    weatherMeterHealth_t health;
+    uint32_t laps;
+    uint32_t ms;
+
+    testStart( &_sim, _trace, sizeof( _trace ) / sizeof( _trace[0] ) );
+
+    // 10 pulses a second, 1000 ticks apart
+    testPlay( &_sim, 2000, 1000, 0 );
+    for( ms=2000; ms<TEST_SEGMENT_MS; ms+=1000 )
+    {
+        testPlay( &_sim, 1000, 1000, 0 );
+        TEST_NEAR( getWindSpeed_cMPH(), WIND_SPEED_MILLI_MPH, 1 );
+        TEST_NEAR( getWindSpeedPeriod(), WIND_SPEED_CAPTURE_TICK_HZ / 10, 1 );
+        TEST_NEAR( getWindSpeedCount(), 10, 1 );
+    }
+    TEST_CHECK( getWeatherMeterHealth( &health ) == 0 );
+    TEST_CHECK( health.windSpeedWraps == 0 );
+
+    // The ring laps every call, the speed comes from the rate over it
+    testPlay( &_sim, 2000, 1000, 0 );
+    getWeatherMeterHealth( &health );
+    laps = health.windSpeedWraps;
+    for( ms=2000; ms<TEST_SEGMENT_MS; ms+=1000 )
+    {
+        testPlay( &_sim, 1000, 1000, 0 );
+        TEST_NEAR( getWindSpeed_cMPH(), TEST_SQUALL_CMPH, 5 );
+        TEST_NEAR( getWindSpeedCount(), TEST_SQUALL_CMPH * 10.0 / WIND_SPEED_MILLI_MPH, 1 );
+        getWeatherMeterHealth( &health );
+        TEST_CHECK( health.windSpeedWraps == laps + 1 );
+        laps = health.windSpeedWraps;
+    }
+
+    // No pulse for longer than the stall time
+    testPlay( &_sim, WIND_SPEED_CAPTURE_STALL_MS + 2000, 1000, 0 );
+    TEST_CHECK( getWindSpeed_cMPH() == 0 );
+    TEST_CHECK( getWindSpeedPeriod() == 0 );
+    TEST_CHECK( getWindSpeedCount() == 0 );
+
+    return testDone();
+}
+
+// End of file - testCapture.c
@@ -0,0 +1,106 @@
+/** @file testDebounce.c
+*
+* @brief    Checks the debounced direction: the first reading is taken
+*           at once, a flicker shorter than WIND_VANE_DEBOUNCE_COUNT
+*           buffers or WIND_VANE_DEBOUNCE_DWELL_MS is not, an open vane
+*           changes nothing, and a direction held long enough is taken
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+#if !WIND_VANE_DEBOUNCE
+#error "testDebounce needs WIND_VANE_DEBOUNCE"
+#endif
+
+/**
+ * @brief   TEST_BUFFER_MS - the time a wind vane buffer takes
+ */
+#define TEST_BUFFER_MS ( WIND_VANE_ADC_BUF_SIZE / WEATHER_SIM_ADC_SAMPLES_PER_MS )
+/**
+ * @brief   TEST_HOLD - the buffers a new direction takes to be taken, the
+ *          dwell counts from the first of them
+ */
+#if WIND_VANE_DEBOUNCE_COUNT
+#define TEST_HOLD WIND_VANE_DEBOUNCE_COUNT
+#else
+#define TEST_HOLD ( ( WIND_VANE_DEBOUNCE_DWELL_MS + TEST_BUFFER_MS - 1 ) / TEST_BUFFER_MS + 1 )
+#endif
+
+static const weatherSimSegment_t _trace[] =
+{
+    //  ms                                  direction   offset  noise   cMPH    milli-in/hr
+    {  TEST_BUFFER_MS,                      WSW,             0,     8,      0,      0 },
+    {  ( TEST_HOLD - 1 ) * TEST_BUFFER_MS,  W,               0,     8,      0,      0 },
+    {  TEST_BUFFER_MS,                      WSW,             0,     8,      0,      0 },
+    {  4 * TEST_HOLD * TEST_BUFFER_MS,      WEATHER_SIM_VANE_OPEN, 0, 0,    0,      0 },
+    {  2 * TEST_HOLD * TEST_BUFFER_MS,      W,               0,     8,      0,      0 },
+};
+
+static weatherSim_t _sim;
+
+int main( void )
+{
+    uint32_t i;
+
+    testStart( &_sim, _trace, sizeof( _trace ) / sizeof( _trace[0] ) );
+    TEST_CHECK( getWindVaneDirectionDebounced() == WIND_VANE_DIRECTIONS_COUNT );
+
+    // Taken at once
+    testPlay( &_sim, TEST_BUFFER_MS, 0, 0 );
+    TEST_CHECK( getWindVaneDirectionDebounced() == WSW );
+    TEST_CHECK( getWindVaneDirChangeCount() == 1 );
+    TEST_CHECK( getWindVaneDirChanged() == 1 );
+    TEST_CHECK( getWindVaneDirChanged() == 0 );
+
+    // One buffer short of being taken, then back
+    for( i=0; i<TEST_HOLD - 1; i++ )
+    {
+        testPlay( &_sim, TEST_BUFFER_MS, 0, 0 );
+        TEST_CHECK( getWindVaneDirection() == W );
+        TEST_CHECK( getWindVaneDirectionDebounced() == WSW );
+    }
+    testPlay( &_sim, TEST_BUFFER_MS, 0, 0 );
+    TEST_CHECK( getWindVaneDirectionDebounced() == WSW );
+
+    // The open vane neither changes it nor times a candidate
+    testPlay( &_sim, 4 * TEST_HOLD * TEST_BUFFER_MS, 0, 0 );
+    TEST_CHECK( getWindVaneDirection() == WIND_VANE_DIRECTIONS_COUNT );
+    TEST_CHECK( getWindVaneDirectionDebounced() == WSW );
+    TEST_CHECK( getWindVaneDirChangeCount() == 1 );
+    TEST_CHECK( getWindVaneDirChanged() == 0 );
+
+    // Held, taken on the last buffer it needs
+    for( i=0; i<TEST_HOLD - 1; i++ )
+    {
+        testPlay( &_sim, TEST_BUFFER_MS, 0, 0 );
+        TEST_CHECK( getWindVaneDirectionDebounced() == WSW );
+    }
+    testPlay( &_sim, TEST_BUFFER_MS, 0, 0 );
+    TEST_CHECK( getWindVaneDirectionDebounced() == W );
+    TEST_CHECK( getWindVaneDirChangeCount() == 2 );
+    TEST_CHECK( getWindVaneDirChanged() == 1 );
+
+    testPlay( &_sim, TEST_HOLD * TEST_BUFFER_MS, 0, 0 );
+    TEST_CHECK( getWindVaneDirectionDebounced() == W );
+    TEST_CHECK( getWindVaneDirChangeCount() == 2 );
+
+    return testDone();
+}
+
+// End of file - testDebounce.c
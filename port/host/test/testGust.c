@@ -0,0 +1,107 @@
+/** @file testGust.c
+*
+* @brief    Checks the gust and the peak gust: the gust over the last
+*           WIND_GUST_SAMPLES seconds, the peak held with its time and
+*           direction, and expiring after WIND_GUST_PEAK_MS to the next
+*           highest gust of the window
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+#if !WIND_GUST
+#error "testGust needs WIND_GUST"
+#endif
+
+/**
+ * @brief   TEST_BASE_CMPH / TEST_GUST_CMPH - 10 and 100 pulses a second
+ */
+#define TEST_BASE_CMPH WIND_SPEED_MILLI_MPH
+#define TEST_GUST_CMPH ( 10 * WIND_SPEED_MILLI_MPH )
+/**
+ * @brief   TEST_GUST_END - when the big gust ends
+ */
+#define TEST_GUST_END ( 30000 + WIND_GUST_SAMPLES * 1000 )
+/**
+ * @brief   TEST_SECOND_MS - how long after it a second, smaller gust
+ */
+#define TEST_SECOND_MS 10000
+
+static const weatherSimSegment_t _trace[] =
+{
+    //  ms                          direction   offset  noise   cMPH            milli-in/hr
+    {  30000,                       W,               0,     8, TEST_BASE_CMPH,      0 },
+    {  WIND_GUST_SAMPLES * 1000,    SW,              0,     8, TEST_GUST_CMPH,      0 },
+    {  TEST_SECOND_MS,              W,               0,     8, TEST_BASE_CMPH,      0 },
+    {  1000,                        W,               0,     8, TEST_GUST_CMPH,      0 },
+    {  2 * WIND_GUST_PEAK_MS,       W,               0,     8, TEST_BASE_CMPH,      0 },
+};
+
+static weatherSim_t _sim;
+
+int main( void )
+{
+    // The samples at the gust speed among base ones as the gust passes
+    const uint32_t trailing = ( ( WIND_GUST_SAMPLES - 1 ) * TEST_GUST_CMPH + TEST_BASE_CMPH ) / WIND_GUST_SAMPLES;
+    const uint32_t second = ( TEST_GUST_CMPH + ( WIND_GUST_SAMPLES - 1 ) * TEST_BASE_CMPH ) / WIND_GUST_SAMPLES;
+    windGust_t gust;
+
+    testStart( &_sim, _trace, sizeof( _trace ) / sizeof( _trace[0] ) );
+    TEST_CHECK( getWindGustPeak( &gust ) == 1 );
+
+    testPlay( &_sim, 30000, 1000, 0 );
+    TEST_NEAR( getWindGust_cMPH(), TEST_BASE_CMPH, 1 );
+    TEST_NEAR( getWindGustPeak_cMPH(), TEST_BASE_CMPH, 1 );
+
+    // The whole gust is in the last samples
+    testPlay( &_sim, WIND_GUST_SAMPLES * 1000, 1000, 0 );
+    TEST_NEAR( getWindGust_cMPH(), TEST_GUST_CMPH, 1 );
+    TEST_CHECK( getWindGustPeak( &gust ) == 0 );
+    TEST_CHECK( gust.timestamp == TEST_GUST_END );
+    TEST_CHECK( gust.direction == SW );
+    TEST_NEAR( getWindGustPeak_cMPH(), TEST_GUST_CMPH, 1 );
+
+    // The peak holds through the lull and the smaller gust
+    testPlay( &_sim, TEST_SECOND_MS + 1000 + WIND_GUST_SAMPLES * 1000, 1000, 0 );
+    TEST_NEAR( getWindGust_cMPH(), TEST_BASE_CMPH, 1 );
+    TEST_NEAR( getWindGustPeak_cMPH(), TEST_GUST_CMPH, 1 );
+
+    // Until the window passes it, then the highest gust left is the
+    // next one as it passed
+    testPlay( &_sim, TEST_GUST_END + WIND_GUST_PEAK_MS - 1000 - (uint32_t)_sim.ms, 1000, 0 );
+    TEST_NEAR( getWindGustPeak_cMPH(), TEST_GUST_CMPH, 1 );
+    testPlay( &_sim, 1000, 1000, 0 );
+    TEST_NEAR( getWindGustPeak_cMPH(), trailing, 1 );
+    TEST_CHECK( getWindGustPeak( &gust ) == 0 );
+    TEST_CHECK( gust.timestamp == TEST_GUST_END + 1000 );
+
+    // Then the smaller gust
+    testPlay( &_sim, WIND_GUST_SAMPLES * 1000, 1000, 0 );
+    TEST_NEAR( getWindGustPeak_cMPH(), second, 1 );
+    TEST_CHECK( getWindGustPeak( &gust ) == 0 );
+    TEST_CHECK( gust.timestamp > TEST_GUST_END + TEST_SECOND_MS );
+    TEST_CHECK( gust.direction == W );
+
+    // And once that passes too, the base wind
+    testPlay( &_sim, TEST_SECOND_MS + 1000 + WIND_GUST_SAMPLES * 1000, 1000, 0 );
+    TEST_NEAR( getWindGustPeak_cMPH(), TEST_BASE_CMPH, 1 );
+
+    return testDone();
+}
+
+// End of file - testGust.c
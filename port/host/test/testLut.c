@@ -0,0 +1,53 @@
+/** @file testLut.c
+*
+* @brief    Checks the lookup table classifies every ADC code as the scan
+*           of the values table does, for the built in table and one
+*           installed with setWindVaneTables()
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+#if !WIND_VANE_USE_LUT
+#error "testLut needs WIND_VANE_USE_LUT"
+#endif
+
+static weatherSim_t _sim;
+static uint32_t _moved[WIND_VANE_DIRECTIONS_COUNT];
+
+int main( void )
+{
+    uint32_t i;
+
+    testStartCodes( &_sim );
+    testCheckCodes( &_sim, getWindVaneValues() );
+
+    // Bands moved off the built in ones, the table is built again
+    for( i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
+    {
+        _moved[i] = WIND_VANE_VALUES[i] + ( ( i & 1 ) ? 7 : -7 );
+    }
+    testStartCodes( &_sim );
+    TEST_CHECK( setWindVaneTables( _moved, NULL ) == 0 );
+    TEST_CHECK( getWindVaneValues() == _moved );
+    testCheckCodes( &_sim, _moved );
+
+    return testDone();
+}
+
+// End of file - testLut.c
@@ -0,0 +1,149 @@
+/** @file testRollup.c
+*
+* @brief    Checks the rollups: the 2 and 10 minute mean wind and the
+*           direction over them, the hourly and 24 hour rain, and a late
+*           processWindSpeed() putting its whole interval in the newest
+*           bucket, over a few buckets and past the ring
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+#if !WEATHER_ROLLUP
+#error "testRollup needs WEATHER_ROLLUP"
+#endif
+
+/**
+ * @brief   TEST_MINUTE / TEST_HOUR - in ms
+ */
+#define TEST_MINUTE 60000UL
+#define TEST_HOUR ( 60 * TEST_MINUTE )
+/**
+ * @brief   TEST_BASE_CMPH - 10 pulses a second
+ */
+#define TEST_BASE_CMPH WIND_SPEED_MILLI_MPH
+/**
+ * @brief   TEST_WET / TEST_DRIZZLE - 600 and 100 tips an hour
+ */
+#define TEST_WET ( 600 * RAIN_BUCKET_MILLI_INCH )
+#define TEST_DRIZZLE ( 100 * RAIN_BUCKET_MILLI_INCH )
+
+static const weatherSimSegment_t _wind[] =
+{
+    //  ms              direction   offset  noise   cMPH                milli-in/hr
+    {  8 * TEST_MINUTE, W,               0,     8, TEST_BASE_CMPH,          0 },
+    {  2 * TEST_MINUTE, E,               0,     8, 2 * TEST_BASE_CMPH,      0 },
+    {  TEST_HOUR,       E,               0,     8, TEST_BASE_CMPH,          0 },
+};
+
+static const weatherSimSegment_t _rain[] =
+{
+    {  TEST_HOUR,       N,               0,     0, 0,                       0 },
+    {  6 * TEST_HOUR,   N,               0,     0, 0,                TEST_WET },
+    {  18 * TEST_HOUR,  N,               0,     0, 0,            TEST_DRIZZLE },
+};
+
+static weatherSim_t _sim;
+
+static void _testWind( void )
+{
+    uint16_t direction;
+    uint16_t steadiness;
+
+    testStart( &_sim, _wind, sizeof( _wind ) / sizeof( _wind[0] ) );
+    TEST_CHECK( getWindDirRollup( WEATHER_ROLLUP_LEVEL_SECONDS, 120, &direction, NULL ) == 1 );
+    testPlay( &_sim, 10 * TEST_MINUTE, 1000, 0 );
+
+    TEST_NEAR( getWindSpeedMean_cMPH( WEATHER_ROLLUP_LEVEL_SECONDS, 120 ), 2 * TEST_BASE_CMPH, 1 );
+    TEST_NEAR( getWindSpeedMean_cMPH( WEATHER_ROLLUP_LEVEL_MINUTES, 2 ), 2 * TEST_BASE_CMPH, 1 );
+    TEST_NEAR( getWindSpeedMean_cMPH( WEATHER_ROLLUP_LEVEL_MINUTES, 10 ), 1.2 * TEST_BASE_CMPH, 1 );
+    TEST_CHECK( getWindDirRollup( WEATHER_ROLLUP_LEVEL_SECONDS, 120, &direction, &steadiness ) == 0 );
+    TEST_NEAR( direction, 900, 5 );
+    TEST_NEAR( steadiness, 1000, 5 );
+    // 8 minutes W against 2 E leaves W, 6/10 of a unit vector long
+    TEST_CHECK( getWindDirRollup( WEATHER_ROLLUP_LEVEL_MINUTES, 10, &direction, &steadiness ) == 0 );
+    TEST_NEAR( direction, 2700, 5 );
+    TEST_NEAR( steadiness, 600, 5 );
+}
+
+static void _testGap( void )
+{
+    uint32_t count;
+    uint32_t ms;
+
+    // Settled on one call a second, then 10 seconds late
+    testPlay( &_sim, 5 * TEST_MINUTE, 1000, 0 );
+    testPlay( &_sim, 10000, 0, 0 );
+    processWindSpeed();
+
+    // The newest bucket holds it all, the ones it skipped are empty
+    TEST_CHECK( getWindSpeedRollup( WEATHER_ROLLUP_LEVEL_SECONDS, 1, &count, &ms ) == 0 );
+    TEST_NEAR( count, 100, 1 );
+    TEST_CHECK( ms == 10000 );
+    TEST_CHECK( getWindSpeedRollup( WEATHER_ROLLUP_LEVEL_SECONDS, 10, &count, &ms ) == 0 );
+    TEST_NEAR( count, 100, 1 );
+    TEST_CHECK( ms == 10000 );
+    TEST_CHECK( getWindSpeedRollup( WEATHER_ROLLUP_LEVEL_SECONDS, 11, &count, &ms ) == 0 );
+    TEST_NEAR( count, 110, 1 );
+    TEST_CHECK( ms == 11000 );
+    TEST_NEAR( getWindSpeedMean_cMPH( WEATHER_ROLLUP_LEVEL_SECONDS, 120 ), TEST_BASE_CMPH, 1 );
+
+    // Longer than the seconds ring, which then holds that one bucket
+    testPlay( &_sim, ( WEATHER_ROLLUP_SECONDS + 180 ) * 1000, 0, 0 );
+    processWindSpeed();
+    TEST_CHECK( getWindSpeedRollup( WEATHER_ROLLUP_LEVEL_SECONDS, WEATHER_ROLLUP_SECONDS, &count, &ms ) == 0 );
+    TEST_NEAR( count, ( WEATHER_ROLLUP_SECONDS + 180 ) * 10, 1 );
+    TEST_CHECK( ms == ( WEATHER_ROLLUP_SECONDS + 180 ) * 1000 );
+    TEST_NEAR( getWindSpeedMean_cMPH( WEATHER_ROLLUP_LEVEL_MINUTES, 10 ), TEST_BASE_CMPH, 1 );
+
+    // And back on time
+    testPlay( &_sim, 2 * TEST_MINUTE, 1000, 0 );
+    TEST_NEAR( getWindSpeedMean_cMPH( WEATHER_ROLLUP_LEVEL_SECONDS, 120 ), TEST_BASE_CMPH, 1 );
+    TEST_CHECK( getWindSpeedRollup( WEATHER_ROLLUP_LEVEL_SECONDS, 1, &count, &ms ) == 0 );
+    TEST_CHECK( ms == 1000 );
+}
+
+static void _testRain( void )
+{
+    uint32_t tips;
+
+    testStart( &_sim, _rain, sizeof( _rain ) / sizeof( _rain[0] ) );
+    testPlay( &_sim, 7 * TEST_HOUR, 0, TEST_MINUTE );
+    TEST_CHECK( getRainRollup( WEATHER_ROLLUP_LEVEL_MINUTES, 60, &tips ) == 0 );
+    TEST_NEAR( tips, 600, 1 );
+    TEST_NEAR( getRainTotal_milliIn( WEATHER_ROLLUP_LEVEL_HOURS, 24 ), 6 * TEST_WET, RAIN_BUCKET_MILLI_INCH );
+
+    // The day covers the last 24 hours, not the dry first one
+    testPlay( &_sim, 18 * TEST_HOUR, 0, TEST_MINUTE );
+    TEST_NEAR( getRainTotal_milliIn( WEATHER_ROLLUP_LEVEL_MINUTES, 60 ), TEST_DRIZZLE, RAIN_BUCKET_MILLI_INCH );
+    TEST_NEAR( getRainTotal_milliIn( WEATHER_ROLLUP_LEVEL_HOURS, 1 ), TEST_DRIZZLE, RAIN_BUCKET_MILLI_INCH );
+    TEST_NEAR( getRainTotal_milliIn( WEATHER_ROLLUP_LEVEL_HOURS, 24 ), 6 * TEST_WET + 18 * TEST_DRIZZLE,
+               RAIN_BUCKET_MILLI_INCH );
+    TEST_CHECK( getRainRollup( WEATHER_ROLLUP_LEVEL_DAYS, 1, &tips ) == 0 );
+    TEST_NEAR( tips, 6 * 600 + 17 * 100, 1 );
+}
+
+int main( void )
+{
+    _testWind();
+    _testGap();
+    _testRain();
+    return testDone();
+}
+
+// End of file - testRollup.c
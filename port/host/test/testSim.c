@@ -0,0 +1,131 @@
+/** @file testSim.c
+*
+* @brief    Plays scripted traces through the simulator and checks the
+*           readings: a steady direction, a vane hovering on a band edge,
+*           an open vane, a known wind speed and a known rain rate
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include "weatherMeterTest.h"
+
+/**
+ * @brief   Whole numbers of pulses and tips per call: 10 pulses a second
+ *          and a tip every 6 seconds
+ */
+#define TEST_WIND_CMPH      WIND_SPEED_MILLI_MPH
+#define TEST_RAIN_MILLI_IN  ( 600 * RAIN_BUCKET_MILLI_INCH )
+
+static const weatherSimSegment_t _steady[] =
+{
+    //  ms      direction   offset  noise   cMPH            milli-in/hr
+    {  120000, WSW,              0,    16, TEST_WIND_CMPH, TEST_RAIN_MILLI_IN },
+};
+
+static const weatherSimSegment_t _hover[] =
+{
+    {   10000, SE, WIND_VANE_CODE_BAND,  4,              0, 0 },
+};
+
+static const weatherSimSegment_t _open[] =
+{
+    {    1000, WEATHER_SIM_VANE_OPEN, 0, 0,              0, 0 },
+};
+
+static const weatherSimSegment_t _uneven[] =
+{   // 160.9 pulses in 10 seconds
+    {  100000, N,                0,     0,           2400, 0 },
+};
+
+static weatherSim_t _sim;
+
+static void _testSteady( void )
+{
+    uint8_t string[4];
+
+    testStart( &_sim, _steady, 1 );
+    testPlay( &_sim, 120000, 1000, 60000 );
+
+    TEST_CHECK( getWindVaneDirection() == WSW );
+    getWindVaneDirString( getWindVaneDirection(), string );
+    TEST_CHECK( strcmp( (const char *)string, "WSW" ) == 0 );
+    // The simulator pulses at even steps, every reading is exact
+    TEST_NEAR( getWindSpeed_cMPH(), TEST_WIND_CMPH, 1 );
+    TEST_NEAR( getRainfall_milliInPerHr(), TEST_RAIN_MILLI_IN, 1 );
+}
+
+static void _testHover( void )
+{
+    windVaneDir_t dir;
+    uint32_t inBand = 0;
+    uint32_t outOfBand = 0;
+
+    testStart( &_sim, _hover, 1 );
+    while( testPlay( &_sim, 1, 0, 0 ) != 0 )
+    {
+        dir = getWindVaneDirection();
+        if( dir == SE )
+        {
+            inBand++;
+        }
+        else
+        {   // Never a neighbour
+            TEST_CHECK( dir == WIND_VANE_DIRECTIONS_COUNT );
+            outOfBand++;
+        }
+    }
+    // The mean falls either side of the edge
+    TEST_CHECK( inBand != 0 );
+    TEST_CHECK( outOfBand != 0 );
+}
+
+static void _testOpen( void )
+{
+    uint8_t string[4];
+
+    testStart( &_sim, _open, 1 );
+    testPlay( &_sim, 1000, 0, 0 );
+
+    TEST_CHECK( getWindVaneDirection() == WIND_VANE_DIRECTIONS_COUNT );
+    getWindVaneDirString( getWindVaneDirection(), string );
+    TEST_CHECK( strcmp( (const char *)string, "ERR" ) == 0 );
+}
+
+static void _testUneven( void )
+{
+    uint32_t ms;
+
+    testStart( &_sim, _uneven, 1 );
+    for( ms=0; ms<100000; ms+=10000 )
+    {
+        testPlay( &_sim, 10000, 10000, 0 );
+        // A pulse either way over the interval
+        TEST_NEAR( getWindSpeed_cMPH(), 2400, WIND_SPEED_MILLI_MPH / 100.0 );
+    }
+}
+
+int main( void )
+{
+    _testSteady();
+    _testHover();
+    _testOpen();
+    _testUneven();
+    return testDone();
+}
+
+// End of file - testSim.c
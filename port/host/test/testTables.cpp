@@ -0,0 +1,45 @@
+/** @file testTables.cpp
+*
+* @brief    Checks the tables weatherMeterTables.hpp generates classify
+*           every ADC code as the scan of their values table does
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+#include "weatherMeterTables.hpp"
+
+// 4.7k pull-up to 3.3V, ADC reference 3.3V, 12 bit ADC
+typedef windVaneTables< sparkfunVane< 4700, 3300, 3300, 12 > > vaneTables;
+
+static weatherSim_t _sim;
+
+int8_t testInstallTables( void )
+{
+    return vaneTables::install();
+}
+
+int main( void )
+{
+    testStartCodes( &_sim );
+    TEST_CHECK( getWindVaneValues() == vaneTables::values.v );
+    testCheckCodes( &_sim, vaneTables::values.v );
+
+    return testDone();
+}
+
+// End of file - testTables.cpp
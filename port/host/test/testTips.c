@@ -0,0 +1,131 @@
+/** @file testTips.c
+*
+* @brief    Plays rain traces through the simulator with the rain bucket
+*           timed tip by tip: the rate with no processRainBucket() calls, a
+*           change of rate followed after RAIN_BUCKET_TIPS_AVERAGE tips,
+*           the decay once it stops, the switch bouncing and the tip events
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+/**
+ * @brief   A tip every 6 seconds, then one every 36 seconds
+ */
+#define TEST_FAST_MS        6000
+#define TEST_SLOW_MS        36000
+#define TEST_FAST_MILLI_IN  ( RAIN_BUCKET_MILLI_INCH * 3600000UL / TEST_FAST_MS )
+#define TEST_SLOW_MILLI_IN  ( RAIN_BUCKET_MILLI_INCH * 3600000UL / TEST_SLOW_MS )
+#define TEST_FAST_TIPS      10
+#define TEST_SLOW_TIPS      RAIN_BUCKET_TIPS_AVERAGE
+#define TEST_DRY_MS         60000
+
+static const weatherSimSegment_t _shower[] =
+{
+    //  ms                                  direction offset noise cMPH milli-in/hr
+    { TEST_FAST_MS * TEST_FAST_TIPS,        N,        0,     0,    0,   TEST_FAST_MILLI_IN },
+    { TEST_SLOW_MS * TEST_SLOW_TIPS,        N,        0,     0,    0,   TEST_SLOW_MILLI_IN },
+    { RAIN_BUCKET_TIPS_TIMEOUT_MS + 1000,   N,        0,     0,    0,   0 },
+};
+
+static const weatherSimSegment_t _bounce[] =
+{
+    { 10000,                                N,        0,     0,    0,   TEST_FAST_MILLI_IN },
+};
+
+static weatherSim_t _sim;
+
+static void _testShower( void )
+{
+#if WEATHER_METER_EVENTS
+    weatherEvent_t event;
+    uint32_t events = 0;
+    uint32_t last = 0;
+#endif
+    uint32_t tip;
+
+    testStart( &_sim, _shower, 3 );
+    TEST_CHECK( getRainfall_milliInPerHr() == 0 );
+
+    // Timed from the tips alone, processRainBucket() is never called
+    testPlay( &_sim, TEST_FAST_MS * TEST_FAST_TIPS, 0, 0 );
+    TEST_CHECK( getRainBucketTips() == TEST_FAST_TIPS );
+    TEST_NEAR( getRainfall_milliInPerHr(), TEST_FAST_MILLI_IN, 1 );
+
+#if WEATHER_METER_EVENTS
+    // One event a tip, a tip interval apart
+    while( popWeatherEvent( &event ) )
+    {
+        if( event.type == WEATHER_EVENT_RAIN_TIP )
+        {
+            TEST_CHECK( event.value == 1 );
+            TEST_CHECK( ( events == 0 ) || ( event.timestamp - last == TEST_FAST_MS ) );
+            last = event.timestamp;
+            events++;
+        }
+    }
+    TEST_CHECK( events == TEST_FAST_TIPS );
+#endif
+
+    // The old intervals age out of the average a tip at a time
+    for( tip=1; tip<=TEST_SLOW_TIPS; tip++ )
+    {
+        testPlay( &_sim, TEST_SLOW_MS, 0, 0 );
+        TEST_CHECK( getRainBucketTips() == TEST_FAST_TIPS + tip );
+        if( tip < TEST_SLOW_TIPS )
+        {
+            TEST_CHECK( getRainfall_milliInPerHr() > TEST_SLOW_MILLI_IN + 1 );
+        }
+    }
+    TEST_NEAR( getRainfall_milliInPerHr(), TEST_SLOW_MILLI_IN, 1 );
+
+    // Stopped, the rate falls as one tip over the wait since the last
+    testPlay( &_sim, TEST_DRY_MS, 0, 0 );
+    TEST_NEAR( getRainfall_milliInPerHr(), RAIN_BUCKET_MILLI_INCH * 3600000UL / TEST_DRY_MS, 1 );
+    testPlay( &_sim, RAIN_BUCKET_TIPS_TIMEOUT_MS - TEST_DRY_MS - 1000, 0, 0 );
+    TEST_CHECK( getRainfall_milliInPerHr() != 0 );
+    testPlay( &_sim, 1000, 0, 0 );
+    TEST_CHECK( getRainfall_milliInPerHr() == 0 );
+    TEST_CHECK( getRainBucketTips() == TEST_FAST_TIPS + TEST_SLOW_TIPS );
+}
+
+static void _testBounce( void )
+{
+    testStart( &_sim, _bounce, 1 );
+    testPlay( &_sim, TEST_FAST_MS, 0, 0 );
+    TEST_CHECK( getRainBucketTips() == 1 );
+
+    // The switch closing again within RAIN_BUCKET_TIPS_DEBOUNCE_MS
+    rainBucketTip();
+    TEST_CHECK( getRainBucketTips() == 1 );
+    testPlay( &_sim, RAIN_BUCKET_TIPS_DEBOUNCE_MS - 1, 0, 0 );
+    rainBucketTip();
+    TEST_CHECK( getRainBucketTips() == 1 );
+    testPlay( &_sim, 1, 0, 0 );
+    rainBucketTip();
+    TEST_CHECK( getRainBucketTips() == 2 );
+}
+
+int main( void )
+{
+    _testShower();
+    _testBounce();
+    return testDone();
+}
+
+// End of file - testTips.c
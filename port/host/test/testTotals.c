@@ -0,0 +1,186 @@
+/** @file testTotals.c
+*
+* @brief    Plays two showers and a day through the simulator with the rain
+*           totals on: the running totals, the hour ageing out, the rain
+*           events and their start and stop events, and the day closing by
+*           resetRainDay() and by RAIN_TOTALS_DAY_MS with the hook called
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+/**
+ * @brief   10 tips a minute, processRainBucket() once a minute
+ */
+#define TEST_MINUTE_MS      60000UL
+#define TEST_MILLI_IN       ( 600 * RAIN_BUCKET_MILLI_INCH )
+#define TEST_TIPS_MINUTE    10
+#define TEST_FIRST_MINUTES  30
+#define TEST_SECOND_MINUTES 10
+#define TEST_AFTER_MINUTES  5
+#define TEST_DRY_MINUTES    ( RAIN_EVENT_DRY_MINUTES + 30 )
+#define TEST_DAYS           4
+
+static const weatherSimSegment_t _showers[] =
+{
+    //  ms                                                      dir offset noise cMPH milli-in/hr
+    { TEST_FIRST_MINUTES * TEST_MINUTE_MS,                      N,  0,     0,    0,   TEST_MILLI_IN },
+    { TEST_DRY_MINUTES * TEST_MINUTE_MS,                        N,  0,     0,    0,   0 },
+    { ( TEST_SECOND_MINUTES + TEST_AFTER_MINUTES ) * TEST_MINUTE_MS, N, 0, 0,    0,   TEST_MILLI_IN },
+    { RAIN_TOTALS_DAY_MS,                                       N,  0,     0,    0,   0 },
+};
+
+static weatherSim_t _sim;
+static uint32_t _days[TEST_DAYS];
+static uint32_t _dayCount;
+
+static void _dayHook( weatherMeter_t *wm, uint32_t tips )
+{
+    (void)wm;
+    if( _dayCount < TEST_DAYS )
+    {
+        _days[_dayCount] = tips;
+    }
+    _dayCount++;
+}
+
+#if WEATHER_METER_EVENTS
+/**
+ * @brief   Drains the events, keeping the last rain event start or stop
+ */
+static uint32_t _drainRainEvents( weatherEvent_t *last )
+{
+    weatherEvent_t event;
+    uint32_t count = 0;
+
+    while( popWeatherEvent( &event ) )
+    {
+        if( ( event.type == WEATHER_EVENT_RAIN_START ) || ( event.type == WEATHER_EVENT_RAIN_STOP ) )
+        {
+            *last = event;
+            count++;
+        }
+    }
+    return count;
+}
+#endif
+
+static void _testShowers( void )
+{
+    const uint32_t first = TEST_FIRST_MINUTES * TEST_TIPS_MINUTE;
+    const uint32_t second = TEST_SECOND_MINUTES * TEST_TIPS_MINUTE;
+    const uint32_t after = TEST_AFTER_MINUTES * TEST_TIPS_MINUTE;
+    rainTotals_t totals;
+#if WEATHER_METER_EVENTS
+    weatherEvent_t event;
+#endif
+
+    testStart( &_sim, _showers, 4 );
+    setRainDayHook( _dayHook );
+    TEST_CHECK( getRainTotals( NULL ) == 1 );
+
+    // The first shower, every total has all of it
+    testPlay( &_sim, TEST_FIRST_MINUTES * TEST_MINUTE_MS, 0, TEST_MINUTE_MS );
+    TEST_CHECK( getRainTotals( &totals ) == 0 );
+    TEST_CHECK( totals.total == first );
+    TEST_CHECK( totals.lastHour == first );
+    TEST_CHECK( totals.last24h == first );
+    TEST_CHECK( totals.today == first );
+    TEST_CHECK( totals.raining == 1 );
+    TEST_CHECK( totals.eventTips == first );
+    TEST_CHECK( totals.eventStart == TEST_MINUTE_MS );
+    TEST_CHECK( totals.eventEnd == TEST_FIRST_MINUTES * TEST_MINUTE_MS );
+#if WEATHER_METER_EVENTS
+    TEST_CHECK( _drainRainEvents( &event ) == 1 );
+    TEST_CHECK( event.type == WEATHER_EVENT_RAIN_START );
+    TEST_CHECK( event.value == TEST_TIPS_MINUTE );
+    TEST_CHECK( event.timestamp == TEST_MINUTE_MS );
+#endif
+
+    // Half an hour dry, the hour still holds the shower
+    testPlay( &_sim, 30 * TEST_MINUTE_MS, 0, TEST_MINUTE_MS );
+    getRainTotals( &totals );
+    TEST_CHECK( totals.lastHour == first );
+    // A minute more and its first minute ages out
+    testPlay( &_sim, TEST_MINUTE_MS, 0, TEST_MINUTE_MS );
+    getRainTotals( &totals );
+    TEST_CHECK( totals.lastHour == first - TEST_TIPS_MINUTE );
+
+    // The event ends after RAIN_EVENT_DRY_MINUTES without a tip
+    testPlay( &_sim, ( RAIN_EVENT_DRY_MINUTES - 31 - 1 ) * TEST_MINUTE_MS, 0, TEST_MINUTE_MS );
+    getRainTotals( &totals );
+    TEST_CHECK( totals.raining == 1 );
+    testPlay( &_sim, TEST_MINUTE_MS, 0, TEST_MINUTE_MS );
+    getRainTotals( &totals );
+    TEST_CHECK( totals.raining == 0 );
+    TEST_CHECK( totals.eventTips == first );
+    TEST_CHECK( totals.lastHour == 0 );
+    TEST_CHECK( totals.last24h == first );
+#if WEATHER_METER_EVENTS
+    TEST_CHECK( _drainRainEvents( &event ) == 1 );
+    TEST_CHECK( event.type == WEATHER_EVENT_RAIN_STOP );
+    TEST_CHECK( event.value == first );
+    TEST_CHECK( event.timestamp == ( TEST_FIRST_MINUTES + RAIN_EVENT_DRY_MINUTES ) * TEST_MINUTE_MS );
+#endif
+
+    // The second shower is a new event, the totals go on
+    testPlay( &_sim, ( TEST_DRY_MINUTES - RAIN_EVENT_DRY_MINUTES + TEST_SECOND_MINUTES ) * TEST_MINUTE_MS,
+              0, TEST_MINUTE_MS );
+    getRainTotals( &totals );
+    TEST_CHECK( totals.raining == 1 );
+    TEST_CHECK( totals.eventTips == second );
+    TEST_CHECK( totals.total == first + second );
+    TEST_CHECK( totals.last24h == first + second );
+    TEST_CHECK( totals.today == first + second );
+#if WEATHER_METER_EVENTS
+    TEST_CHECK( _drainRainEvents( &event ) == 1 );
+    TEST_CHECK( event.type == WEATHER_EVENT_RAIN_START );
+#endif
+
+    // The application's midnight, the hook gets the day so far
+    resetRainDay();
+    TEST_CHECK( _dayCount == 1 );
+    TEST_CHECK( _days[0] == first + second );
+    getRainTotals( &totals );
+    TEST_CHECK( totals.today == 0 );
+    TEST_CHECK( totals.total == first + second );
+
+#if RAIN_TOTALS_DAY_MS
+    // The next day closes RAIN_TOTALS_DAY_MS after the reset
+    testPlay( &_sim, RAIN_TOTALS_DAY_MS - TEST_MINUTE_MS, 0, TEST_MINUTE_MS );
+    TEST_CHECK( _dayCount == 1 );
+    getRainTotals( &totals );
+    TEST_CHECK( totals.today == after );
+    testPlay( &_sim, TEST_MINUTE_MS, 0, TEST_MINUTE_MS );
+    TEST_CHECK( _dayCount == 2 );
+    TEST_CHECK( _days[1] == after );
+    getRainTotals( &totals );
+    TEST_CHECK( totals.today == 0 );
+    TEST_CHECK( totals.total == first + second + after );
+#else
+    (void)after;
+#endif
+}
+
+int main( void )
+{
+    _testShowers();
+    return testDone();
+}
+
+// End of file - testTotals.c
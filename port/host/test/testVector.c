@@ -0,0 +1,150 @@
+/** @file testVector.c
+*
+* @brief    Checks the vector averaged wind direction: a steady vane, a
+*           vane swinging between two directions either side of E and of
+*           N, a turn the short window follows before the long one, and no
+*           mean without valid readings
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+#if !WIND_VANE_VECTOR_AVG
+#error "testVector needs WIND_VANE_VECTOR_AVG"
+#endif
+
+/**
+ * @brief   TEST_BUFFER_MS - the time a wind vane buffer takes
+ */
+#define TEST_BUFFER_MS ( WIND_VANE_ADC_BUF_SIZE / WEATHER_SIM_ADC_SAMPLES_PER_MS )
+/**
+ * @brief   TEST_BLOCK_MS - the time a block of the windows takes
+ */
+#define TEST_BLOCK_MS ( WIND_VANE_VECTOR_BLOCK * TEST_BUFFER_MS )
+/**
+ * @brief   TEST_LONG_MS - the time the long window takes
+ */
+#define TEST_LONG_MS ( WIND_VANE_VECTOR_LONG_BLOCKS * TEST_BLOCK_MS )
+/**
+ * @brief   TEST_SWINGS - the most segments of a swinging vane
+ */
+#define TEST_SWINGS ( 2 * TEST_LONG_MS / TEST_BLOCK_MS )
+
+static weatherSimSegment_t _trace[TEST_SWINGS];
+static weatherSim_t _sim;
+
+/**
+ * @brief   Starts the station on a vane swinging between two directions,
+ *          half a block on each, for the long window twice over
+ * @param   a - The first direction
+ * @param   b - The second direction
+ * @retval  None
+ */
+static void _swing( windVaneDir_t a, windVaneDir_t b )
+{
+    uint32_t i;
+
+    for( i=0; i<TEST_SWINGS; i++ )
+    {
+        _trace[i].ms = TEST_BLOCK_MS / 2;
+        _trace[i].direction = ( i & 1 ) ? b : a;
+        _trace[i].noise = 8;
+    }
+    testStart( &_sim, _trace, TEST_SWINGS );
+    testPlay( &_sim, TEST_SWINGS * TEST_BLOCK_MS / 2, 0, 0 );
+}
+
+static void _testEmpty( void )
+{
+    uint16_t direction;
+
+    _trace[0].ms = TEST_LONG_MS;
+    _trace[0].direction = WEATHER_SIM_VANE_OPEN;
+    testStart( &_sim, _trace, 1 );
+    testPlay( &_sim, TEST_LONG_MS, 0, 0 );
+    TEST_CHECK( getWindVaneMeanDirection( WIND_VANE_WINDOW_SHORT, &direction, NULL ) == 1 );
+    TEST_CHECK( getWindVaneMeanDirection( WIND_VANE_WINDOW_LONG, &direction, NULL ) == 1 );
+}
+
+static void _testSteady( void )
+{
+    uint16_t direction;
+    uint16_t steadiness;
+
+    _trace[0].ms = 2 * TEST_LONG_MS;
+    _trace[0].direction = WSW;
+    _trace[0].noise = 16;
+    testStart( &_sim, _trace, 1 );
+    testPlay( &_sim, 2 * TEST_LONG_MS, 0, 0 );
+    TEST_CHECK( getWindVaneMeanDirection( WIND_VANE_WINDOW_SHORT, &direction, &steadiness ) == 0 );
+    TEST_NEAR( direction, 2475, 1 );
+    TEST_NEAR( steadiness, 1000, 1 );
+    TEST_CHECK( getWindVaneMeanDirection( WIND_VANE_WINDOW_LONG, &direction, &steadiness ) == 0 );
+    TEST_NEAR( direction, 2475, 1 );
+    TEST_NEAR( steadiness, 1000, 1 );
+}
+
+static void _testSwing( void )
+{
+    uint16_t direction;
+    uint16_t steadiness;
+
+    // N and E average to NE, the mean vector 1/sqrt(2) long
+    _swing( N, E );
+    TEST_CHECK( getWindVaneMeanDirection( WIND_VANE_WINDOW_SHORT, &direction, &steadiness ) == 0 );
+    TEST_NEAR( direction, 450, 2 );
+    TEST_NEAR( steadiness, 707, 2 );
+    TEST_CHECK( getWindVaneMeanDirection( WIND_VANE_WINDOW_LONG, &direction, &steadiness ) == 0 );
+    TEST_NEAR( direction, 450, 2 );
+    TEST_NEAR( steadiness, 707, 2 );
+
+    // Across N, not the 180 degrees an arithmetic mean would give
+    _swing( N, NNW );
+    TEST_CHECK( getWindVaneMeanDirection( WIND_VANE_WINDOW_LONG, &direction, &steadiness ) == 0 );
+    TEST_NEAR( direction, 3487.5, 2 );
+    TEST_NEAR( steadiness, 981, 2 );
+}
+
+static void _testTurn( void )
+{
+    uint16_t direction;
+
+    // Past the short window on S, well inside the long one
+    _trace[0].ms = TEST_LONG_MS;
+    _trace[0].direction = N;
+    _trace[0].noise = 8;
+    _trace[1] = _trace[0];
+    _trace[1].direction = S;
+    testStart( &_sim, _trace, 2 );
+    testPlay( &_sim, TEST_LONG_MS + ( WIND_VANE_VECTOR_SHORT_BLOCKS + 1 ) * TEST_BLOCK_MS, 0, 0 );
+    TEST_CHECK( getWindVaneMeanDirection( WIND_VANE_WINDOW_SHORT, &direction, NULL ) == 0 );
+    TEST_NEAR( direction, 1800, 1 );
+    TEST_CHECK( getWindVaneMeanDirection( WIND_VANE_WINDOW_LONG, &direction, NULL ) == 0 );
+    TEST_CHECK( ( direction < 900 ) || ( direction > 2700 ) );
+}
+
+int main( void )
+{
+    _testEmpty();
+    _testSteady();
+    _testSwing();
+    _testTurn();
+    return testDone();
+}
+
+// End of file - testVector.c
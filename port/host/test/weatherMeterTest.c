@@ -0,0 +1,189 @@
+/** @file weatherMeterTest.c
+*
+* @brief    Helpers for the host tests, see weatherMeterTest.h
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterTest.h"
+
+/**
+ * @brief   TEST_CODES - the ADC codes
+ */
+#define TEST_CODES ( 1UL << WIND_VANE_ADC_BITS )
+/**
+ * @brief   TEST_BUFFER_MS - the time the simulated ADC takes to fill the
+ *          wind vane buffer
+ */
+#define TEST_BUFFER_MS ( WIND_VANE_ADC_BUF_SIZE / WEATHER_SIM_ADC_SAMPLES_PER_MS )
+
+static uint32_t _checks;
+static uint32_t _failures;
+static weatherSimSegment_t _codes[TEST_CODES];
+
+#if !WIND_VANE_DOUBLE_BUFFER
+void HAL_ADC_ConvCpltCallback( ADC_HandleTypeDef *hadc )
+{
+    (void)hadc;
+    processWindVane();
+}
+#elif !WIND_VANE_HAL_CALLBACKS
+void HAL_ADC_ConvHalfCpltCallback( ADC_HandleTypeDef *hadc )
+{
+    (void)hadc;
+    processWindVaneFirstHalf();
+}
+
+void HAL_ADC_ConvCpltCallback( ADC_HandleTypeDef *hadc )
+{
+    (void)hadc;
+    processWindVaneSecondHalf();
+}
+#endif /* WIND_VANE_DOUBLE_BUFFER */
+
+#if RAIN_BUCKET_TIPS
+void HAL_GPIO_EXTI_Callback( uint16_t GPIO_Pin )
+{
+    if( GPIO_Pin == WEATHER_SIM_RAIN_PIN )
+    {
+        rainBucketTip();
+    }
+}
+#endif /* RAIN_BUCKET_TIPS */
+
+int8_t testStart( weatherSim_t *sim, const weatherSimSegment_t *trace, uint32_t segments )
+{
+    if( weatherSimInit( sim, trace, segments, 0 ) ||
+        initWeatherMeter( getWeatherMeter() ) ||
+#if WIND_VANE_USE_LUT && WIND_VANE_EXTERNAL_TABLES
+        testInstallTables() ||
+#endif
+        initWindVane( &sim->hadc ) ||
+#if WIND_SPEED_CAPTURE
+        initWindSpeedCapture( &sim->windTimer, TIM_CHANNEL_1 ) ||
+#else
+        initWindSpeed( &sim->windTimer ) ||
+#endif
+#if RAIN_BUCKET_TIPS
+        initRainBucketTips() )
+#else
+        initRainBucket( &sim->rainTimer ) )
+#endif
+    {
+        testCheck( 0, "testStart()", __FILE__, __LINE__ );
+        return 1;
+    }
+    return 0;
+}
+
+int8_t testStartCodes( weatherSim_t *sim )
+{
+    uint32_t code;
+
+    for( code=0; code<TEST_CODES; code++ )
+    {   // Every sample of the buffer reads the code
+        _codes[code].ms = TEST_BUFFER_MS;
+        _codes[code].direction = N;
+        _codes[code].offset = (int16_t)( (int32_t)code - (int32_t)WIND_VANE_VALUES[N] );
+    }
+    return testStart( sim, _codes, TEST_CODES );
+}
+
+void testCheckCodes( weatherSim_t *sim, const uint32_t *values )
+{
+    windVaneDir_t expected;
+    uint32_t code;
+    uint32_t i;
+
+    for( code=0; code<TEST_CODES; code++ )
+    {
+        testPlay( sim, TEST_BUFFER_MS, 0, 0 );
+
+        // The first direction whose band holds the code
+        expected = WIND_VANE_DIRECTIONS_COUNT;
+        for( i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
+        {
+            if( ( code + WIND_VANE_CODE_BAND >= values[i] ) && ( code <= values[i] + WIND_VANE_CODE_BAND ) )
+            {
+                expected = (windVaneDir_t)i;
+                break;
+            }
+        }
+        if( getWindVaneDirection() != expected )
+        {
+            fprintf( stderr, "code %lu reads %d, expected %d\n", (unsigned long)code,
+                     (int)getWindVaneDirection(), (int)expected );
+            testCheck( 0, "getWindVaneDirection() == expected", __FILE__, __LINE__ );
+            return;
+        }
+    }
+    testCheck( 1, "getWindVaneDirection() == expected", __FILE__, __LINE__ );
+}
+
+uint32_t testPlay( weatherSim_t *sim, uint32_t ms, uint32_t speedMs, uint32_t rainMs )
+{
+    uint32_t played;
+
+    for( played=0; played<ms; played++ )
+    {
+        if( weatherSimRun( sim, 1, 1 ) )
+        {   // The trace has ended
+            break;
+        }
+        if( ( speedMs != 0 ) && ( sim->ms % speedMs == 0 ) )
+        {
+            processWindSpeed();
+        }
+        if( ( rainMs != 0 ) && ( sim->ms % rainMs == 0 ) )
+        {
+            processRainBucket();
+        }
+    }
+    return played;
+}
+
+void testCheck( int ok, const char *what, const char *file, int line )
+{
+    _checks++;
+    if( !ok )
+    {
+        _failures++;
+        fprintf( stderr, "%s:%d: failed: %s\n", file, line, what );
+    }
+}
+
+void testNear( double actual, double expected, double tolerance,
+               const char *what, const char *file, int line )
+{
+    double error = ( actual > expected ) ? ( actual - expected ) : ( expected - actual );
+
+    _checks++;
+    if( error > tolerance )
+    {
+        _failures++;
+        fprintf( stderr, "%s:%d: failed: %s is %.3f, expected %.3f +/- %.3f\n",
+                 file, line, what, actual, expected, tolerance );
+    }
+}
+
+int testDone( void )
+{
+    printf( "%lu checks, %lu failed\n", (unsigned long)_checks, (unsigned long)_failures );
+    return( ( _failures != 0 ) ? 1 : 0 );
+}
+
+// End of file - weatherMeterTest.c
@@ -0,0 +1,128 @@
+/** @file weatherMeterTest.h
+*
+* @brief    Helpers for the host tests: starts a station on a simulated
+*           trace, plays it with the process calls at a given cadence, and
+*           checks readings against expectations with a tolerance
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef _weatherMeterTest_H
+#define _weatherMeterTest_H
+
+#include "weatherMeterSim.h"
+
+/**
+ * @brief   Checks a condition, reporting it with where it is when false
+ */
+#define TEST_CHECK( cond ) \
+    testCheck( ( cond ) ? 1 : 0, #cond, __FILE__, __LINE__ )
+
+/**
+ * @brief   Checks a reading is within a tolerance of the expected value
+ */
+#define TEST_NEAR( actual, expected, tolerance ) \
+    testNear( (double)( actual ), (double)( expected ), (double)( tolerance ), #actual, __FILE__, __LINE__ )
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if WIND_VANE_USE_LUT && WIND_VANE_EXTERNAL_TABLES
+/**
+ * @brief   Installs the wind vane tables, as the application would.  The
+ *          test defines it, testStart() calls it before initWindVane()
+ * @param   None
+ * @retval  0 on success, 1 on failure
+ */
+int8_t testInstallTables( void );
+#endif
+
+/**
+ * @brief   Starts the station over on a trace, with the inputs the
+ *          configuration uses
+ * @param   sim - The simulator
+ * @param   trace - The trace
+ * @param   segments - The number of segments in the trace
+ * @retval  0 on success, 1 on failure
+ */
+int8_t testStart( weatherSim_t *sim, const weatherSimSegment_t *trace, uint32_t segments );
+
+/**
+ * @brief   Plays the trace, calling processWindSpeed() and
+ *          processRainBucket() as a main loop would
+ * @param   sim - The simulator
+ * @param   ms - The time to play
+ * @param   speedMs - The period of processWindSpeed() calls, 0 for none
+ * @param   rainMs - The period of processRainBucket() calls, 0 for none
+ * @retval  The time played, short of ms when the trace ended
+ */
+uint32_t testPlay( weatherSim_t *sim, uint32_t ms, uint32_t speedMs, uint32_t rainMs );
+
+/**
+ * @brief   Starts the station over on a trace holding each ADC code in
+ *          turn, for a whole wind vane buffer each
+ * @param   sim - The simulator
+ * @retval  0 on success, 1 on failure
+ */
+int8_t testStartCodes( weatherSim_t *sim );
+
+/**
+ * @brief   Plays the trace of testStartCodes(), checking the direction of
+ *          each code against a scan of a values table
+ * @param   sim - The simulator
+ * @param   values - The values table the station classifies with
+ * @retval  None
+ */
+void testCheckCodes( weatherSim_t *sim, const uint32_t *values );
+
+/**
+ * @brief   Counts a failed check and reports it.  Use TEST_CHECK()
+ * @param   ok - 1 if the check passed
+ * @param   what - The condition
+ * @param   file - The file of the check
+ * @param   line - The line of the check
+ * @retval  None
+ */
+void testCheck( int ok, const char *what, const char *file, int line );
+
+/**
+ * @brief   Counts a reading out of tolerance and reports it.  Use
+ *          TEST_NEAR()
+ * @param   actual - The reading
+ * @param   expected - The expected value
+ * @param   tolerance - How far off the reading may be
+ * @param   what - The reading's expression
+ * @param   file - The file of the check
+ * @param   line - The line of the check
+ * @retval  None
+ */
+void testNear( double actual, double expected, double tolerance,
+               const char *what, const char *file, int line );
+
+/**
+ * @brief   Reports the checks made
+ * @param   None
+ * @retval  The exit code, 0 if every check passed
+ */
+int testDone( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _weatherMeterTest_H */
@@ -0,0 +1,11 @@
+/** @file tim.h
+*
+* @brief    The host stand-in for the CubeMX generated tim.h
+*/
+
+#ifndef _tim_H
+#define _tim_H
+
+#include "halHost.h"
+
+#endif /* _tim_H */
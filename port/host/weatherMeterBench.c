@@ -0,0 +1,598 @@
+/** @file weatherMeterBench.c
+*
+* @brief    Times the entry points of the weather meter library on the
+*           host, for each input distribution, and writes the results as
+*           JSON lines.  Compared against a baseline of an earlier run it
+*           fails when a function got slower than the threshold allows
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "weatherMeterSim.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#define BENCH_HAVE_CYCLES 1
+#else
+#define BENCH_HAVE_CYCLES 0
+#endif
+
+/**
+ * @brief   BENCH_BATCH_NS - the least time a batch of calls runs for, so
+ *          the clock resolution doesn't show
+ */
+#ifndef BENCH_BATCH_NS
+#define BENCH_BATCH_NS 200000.0
+#endif
+/**
+ * @brief   BENCH_REPEATS - batches per measurement, the fastest counts
+ *          as the others were disturbed by something else
+ */
+#ifndef BENCH_REPEATS
+#define BENCH_REPEATS 15
+#endif
+/**
+ * @brief   BENCH_MAX_BASELINE - results a baseline file can hold
+ */
+#define BENCH_MAX_BASELINE 512
+
+/**
+ * @brief   An input distribution: what the vane reads, and the anemometer
+ *          pulses and rain bucket tips counted per process call
+ */
+typedef struct
+{
+    const char *name;
+    weatherSimSegment_t segment;
+    uint32_t windPulses;
+    uint32_t rainTips;
+} benchInput_t;
+
+/**
+ * @brief   An entry point to time
+ */
+typedef struct
+{
+    const char *name;
+    void (*call)( void );
+} benchEntry_t;
+
+/**
+ * @brief   A result of the baseline
+ */
+typedef struct
+{
+    char function[48];
+    char input[16];
+    unsigned long bufSize;
+    double ns;
+} benchResult_t;
+
+static const benchInput_t _inputs[] =
+{   // A still vane, no wind or rain
+    { "calm",     { 1, N,   0,                   0, 0, 0 }, 0, 0 },
+    // A noisy vane well inside its band, moderate wind and rain
+    { "steady",   { 1, WSW, 0,                   8, 0, 0 }, 8, 1 },
+    // A vane on the edge of its band, so the samples fall in and out of
+    // it, and single pulses
+    { "boundary", { 1, SE,  WIND_VANE_CODE_BAND, 4, 0, 0 }, 1, 1 },
+    // An open vane, and counters jumping by their full range
+    { "error",    { 1, WEATHER_SIM_VANE_OPEN, 0, 0, 0, 0 },
+      ( 1UL << WEATHER_METER_COUNTER_BITS ) - 1, ( 1UL << WEATHER_METER_COUNTER_BITS ) - 1 },
+};
+
+static weatherSim_t _sim;
+static const benchInput_t *_input;
+static volatile uint32_t _sink;
+#if WEATHER_METER_USE_DOUBLE
+static volatile double _sinkDouble;
+#endif
+static uint8_t _string[4];
+static benchResult_t _baseline[BENCH_MAX_BASELINE];
+static uint32_t _baselineCount;
+
+/**
+ * @brief   Counts pulses into a simulated counter, like the hardware
+ *          would between two process calls
+ * @param   tim - The counter
+ * @param   pulses - The pulses
+ * @retval  None
+ */
+static void _count( TIM_TypeDef *tim, uint32_t pulses )
+{
+    tim->CNT = ( tim->CNT + pulses ) & tim->ARR;
+}
+
+static void _processWindVane( void )
+{
+    processWindVane();
+}
+
+#if WIND_VANE_DOUBLE_BUFFER
+static void _processWindVaneFirstHalf( void )
+{
+    processWindVaneFirstHalf();
+}
+
+static void _processWindVaneSecondHalf( void )
+{
+    processWindVaneSecondHalf();
+}
+#endif
+
+static void _getWindVaneDirection( void )
+{
+    _sink = getWindVaneDirection();
+}
+
+static void _getWindVaneDirString( void )
+{
+    getWindVaneDirString( (windVaneDir_t)_input->segment.direction, _string );
+}
+
+#if WIND_VANE_DEBOUNCE
+static void _getWindVaneDirectionDebounced( void )
+{
+    _sink = getWindVaneDirectionDebounced();
+}
+#endif
+
+#if WIND_VANE_VOTE
+static void _getWindVaneVoteDirection( void )
+{
+    uint8_t share;
+
+    _sink = getWindVaneVoteDirection( &share );
+}
+#endif
+
+static void _processWindSpeed( void )
+{
+    _count( &_sim.windTim, _input->windPulses );
+    halHostSetTick( HAL_GetTick() + 1000 );
+    processWindSpeed();
+}
+
+static void _getWindSpeed_cMPH( void )
+{
+    _sink = getWindSpeed_cMPH();
+}
+
+static void _getWindSpeed_Q16( void )
+{
+    _sink = getWindSpeed_Q16();
+}
+
+static void _getWindSpeed_Unit( void )
+{
+    _sink = getWindSpeed_Unit();
+}
+
+#if WEATHER_METER_USE_DOUBLE
+static void _getWindSpeed_MPH( void )
+{
+    _sinkDouble = getWindSpeed_MPH();
+}
+#endif
+
+#if WIND_GUST
+static void _getWindGust_cMPH( void )
+{
+    _sink = getWindGust_cMPH();
+}
+
+static void _getWindGustPeak( void )
+{
+    windGust_t gust;
+
+    getWindGustPeak( &gust );
+    _sink = gust.count;
+}
+#endif
+
+#if RAIN_BUCKET_TIPS
+static void _rainBucketTip( void )
+{
+    halHostSetTick( HAL_GetTick() + 1000 );
+    rainBucketTip();
+}
+#endif
+
+static void _processRainBucket( void )
+{
+    _count( &_sim.rainTim, _input->rainTips );
+    halHostSetTick( HAL_GetTick() + 60000 );
+    processRainBucket();
+}
+
+static void _getRainfall_milliInPerHr( void )
+{
+    _sink = getRainfall_milliInPerHr();
+}
+
+static void _getRainfall_Unit( void )
+{
+    _sink = getRainfall_Unit();
+}
+
+#if WEATHER_METER_USE_DOUBLE
+static void _getRainfall_inperhr( void )
+{
+    _sinkDouble = getRainfall_inperhr();
+}
+#endif
+
+#if RAIN_TOTALS
+static void _getRainTotals( void )
+{
+    rainTotals_t totals;
+
+    getRainTotals( &totals );
+    _sink = totals.lastHour;
+}
+#endif
+
+#if WEATHER_ROLLUP
+static void _getWindSpeedMean_cMPH( void )
+{
+    _sink = getWindSpeedMean_cMPH( WEATHER_ROLLUP_LEVEL_MINUTES, 10 );
+}
+#endif
+
+#if WEATHER_METER_EVENTS
+static void _popWeatherEvent( void )
+{
+    weatherEvent_t event;
+
+    _sink = popWeatherEvent( &event );
+}
+#endif
+
+#if WEATHER_METER_SNAPSHOT
+static void _getStationSnapshot( void )
+{
+    stationSnapshot_t snapshot;
+
+    getStationSnapshot( &snapshot );
+    _sink = snapshot.windSpeed_cMPH;
+}
+#endif
+
+static const benchEntry_t _entries[] =
+{
+    { "processWindVane",                _processWindVane },
+#if WIND_VANE_DOUBLE_BUFFER
+    { "processWindVaneFirstHalf",       _processWindVaneFirstHalf },
+    { "processWindVaneSecondHalf",      _processWindVaneSecondHalf },
+#endif
+    { "getWindVaneDirection",           _getWindVaneDirection },
+    { "getWindVaneDirString",           _getWindVaneDirString },
+#if WIND_VANE_DEBOUNCE
+    { "getWindVaneDirectionDebounced",  _getWindVaneDirectionDebounced },
+#endif
+#if WIND_VANE_VOTE
+    { "getWindVaneVoteDirection",       _getWindVaneVoteDirection },
+#endif
+    { "processWindSpeed",               _processWindSpeed },
+    { "getWindSpeed_cMPH",              _getWindSpeed_cMPH },
+    { "getWindSpeed_Q16",               _getWindSpeed_Q16 },
+    { "getWindSpeed_Unit",              _getWindSpeed_Unit },
+#if WEATHER_METER_USE_DOUBLE
+    { "getWindSpeed_MPH",               _getWindSpeed_MPH },
+#endif
+#if WIND_GUST
+    { "getWindGust_cMPH",               _getWindGust_cMPH },
+    { "getWindGustPeak",                _getWindGustPeak },
+#endif
+#if RAIN_BUCKET_TIPS
+    { "rainBucketTip",                  _rainBucketTip },
+#endif
+    { "processRainBucket",              _processRainBucket },
+    { "getRainfall_milliInPerHr",       _getRainfall_milliInPerHr },
+    { "getRainfall_Unit",               _getRainfall_Unit },
+#if WEATHER_METER_USE_DOUBLE
+    { "getRainfall_inperhr",            _getRainfall_inperhr },
+#endif
+#if RAIN_TOTALS
+    { "getRainTotals",                  _getRainTotals },
+#endif
+#if WEATHER_ROLLUP
+    { "getWindSpeedMean_cMPH",          _getWindSpeedMean_cMPH },
+#endif
+#if WEATHER_METER_EVENTS
+    { "popWeatherEvent",                _popWeatherEvent },
+#endif
+#if WEATHER_METER_SNAPSHOT
+    { "getStationSnapshot",             _getStationSnapshot },
+#endif
+};
+
+/**
+ * @brief   Returns a monotonic time
+ * @param   None
+ * @retval  The time in ns
+ */
+static double _nowNs( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec );
+}
+
+/**
+ * @brief   Returns the cycle counter, the time stamp counter on x86
+ * @param   None
+ * @retval  The cycles, 0 where there's no counter
+ */
+static uint64_t _nowCycles( void )
+{
+#if BENCH_HAVE_CYCLES
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief   Starts the station over on an input, and has the simulated
+ *          ADC fill the wind vane buffer from it
+ * @param   input - The input distribution
+ * @retval  0 on success, 1 on failure
+ */
+static int8_t _setup( const benchInput_t *input )
+{
+    _input = input;
+    if( weatherSimInit( &_sim, &input->segment, 1, 1 ) ||
+        initWeatherMeter( getWeatherMeter() ) ||
+        initWindVane( &_sim.hadc ) ||
+#if WIND_SPEED_CAPTURE
+        initWindSpeedCapture( &_sim.windTimer, TIM_CHANNEL_1 ) ||
+#else
+        initWindSpeed( &_sim.windTimer ) ||
+#endif
+#if RAIN_BUCKET_TIPS
+        initRainBucketTips() )
+#else
+        initRainBucket( &_sim.rainTimer ) )
+#endif
+    {
+        return 1;
+    }
+
+    weatherSimRun( &_sim, WIND_VANE_ADC_BUF_SIZE / WEATHER_SIM_ADC_SAMPLES_PER_MS + 1, 1 );
+    processWindVane();
+    return 0;
+}
+
+/**
+ * @brief   Times an entry point, the fastest of BENCH_REPEATS batches
+ * @param   entry - The entry point
+ * @param   ns - Where to put the time per call in ns
+ * @param   cycles - Where to put the cycles per call
+ * @param   iterations - Where to put the calls per batch
+ * @retval  None
+ */
+static void _measure( const benchEntry_t *entry, double *ns, double *cycles, uint32_t *iterations )
+{
+    uint32_t n = 1;
+    uint32_t i;
+    uint32_t r;
+    double start;
+    double elapsed;
+    uint64_t c;
+
+    // Grow the batch until it is long enough to time
+    for( ;; )
+    {
+        start = _nowNs();
+        for( i=0; i<n; i++ )
+        {
+            entry->call();
+        }
+        if( ( _nowNs() - start >= BENCH_BATCH_NS ) || ( n >= ( 1UL << 30 ) ) )
+        {
+            break;
+        }
+        n <<= 1;
+    }
+
+    *ns = 0;
+    *cycles = 0;
+    for( r=0; r<BENCH_REPEATS; r++ )
+    {
+        c = _nowCycles();
+        start = _nowNs();
+        for( i=0; i<n; i++ )
+        {
+            entry->call();
+        }
+        elapsed = _nowNs() - start;
+        c = _nowCycles() - c;
+
+        if( ( r == 0 ) || ( elapsed / n < *ns ) )
+        {
+            *ns = elapsed / n;
+            *cycles = (double)c / n;
+        }
+    }
+    *iterations = n;
+}
+
+/**
+ * @brief   Reads the results of an earlier run
+ * @param   path - The file
+ * @retval  0 on success, 1 on failure
+ */
+static int8_t _loadBaseline( const char *path )
+{
+    FILE *file = fopen( path, "r" );
+    char line[256];
+    benchResult_t *b;
+
+    if( file == NULL )
+    {
+        return 1;
+    }
+    while( ( _baselineCount < BENCH_MAX_BASELINE ) && ( fgets( line, sizeof( line ), file ) != NULL ) )
+    {
+        b = &_baseline[_baselineCount];
+        if( sscanf( line, "{\"function\":\"%47[^\"]\",\"input\":\"%15[^\"]\",\"bufSize\":%lu,\"ns\":%lf",
+                    b->function, b->input, &b->bufSize, &b->ns ) == 4 )
+        {
+            _baselineCount++;
+        }
+    }
+    fclose( file );
+    return 0;
+}
+
+/**
+ * @brief   Finds the baseline of a result
+ * @param   function - The entry point
+ * @param   input - The input distribution
+ * @retval  The baseline, NULL if there's none
+ */
+static const benchResult_t* _findBaseline( const char *function, const char *input )
+{
+    uint32_t i;
+
+    for( i=0; i<_baselineCount; i++ )
+    {
+        if( ( _baseline[i].bufSize == WIND_VANE_ADC_BUF_SIZE ) &&
+            ( strcmp( _baseline[i].function, function ) == 0 ) &&
+            ( strcmp( _baseline[i].input, input ) == 0 ) )
+        {
+            return &_baseline[i];
+        }
+    }
+    return NULL;
+}
+
+static void _usage( const char *name )
+{
+    fprintf( stderr, "Usage: %s [--out file] [--baseline file] [--threshold percent] [--slack ns]\n"
+                     "  --out        write the results there instead of stdout\n"
+                     "  --baseline   results of an earlier run to compare with\n"
+                     "  --threshold  slowdown over the baseline that fails, default 25%%\n"
+                     "  --slack      ns added to the allowance, for the shortest calls, default 2\n",
+             name );
+}
+
+int main( int argc, char *argv[] )
+{
+    const char *outPath = NULL;
+    const char *baselinePath = NULL;
+    double threshold = 25.0;
+    double slack = 2.0;
+    const benchResult_t *base;
+    FILE *out = stdout;
+    uint32_t regressions = 0;
+    uint32_t iterations;
+    double ns;
+    double cycles;
+    double limit;
+    size_t e;
+    size_t k;
+    int i;
+
+    for( i=1; i<argc; i++ )
+    {
+        if( ( strcmp( argv[i], "--out" ) == 0 ) && ( i + 1 < argc ) )
+        {
+            outPath = argv[++i];
+        }
+        else if( ( strcmp( argv[i], "--baseline" ) == 0 ) && ( i + 1 < argc ) )
+        {
+            baselinePath = argv[++i];
+        }
+        else if( ( strcmp( argv[i], "--threshold" ) == 0 ) && ( i + 1 < argc ) )
+        {
+            threshold = atof( argv[++i] );
+        }
+        else if( ( strcmp( argv[i], "--slack" ) == 0 ) && ( i + 1 < argc ) )
+        {
+            slack = atof( argv[++i] );
+        }
+        else
+        {
+            _usage( argv[0] );
+            return 2;
+        }
+    }
+
+    if( ( baselinePath != NULL ) && ( baselinePath[0] != '\0' ) && _loadBaseline( baselinePath ) )
+    {
+        fprintf( stderr, "Can't read the baseline %s\n", baselinePath );
+        return 2;
+    }
+    if( outPath != NULL )
+    {
+        out = fopen( outPath, "w" );
+        if( out == NULL )
+        {
+            fprintf( stderr, "Can't write %s\n", outPath );
+            return 2;
+        }
+    }
+
+    for( k=0; k<sizeof( _inputs ) / sizeof( _inputs[0] ); k++ )
+    {
+        for( e=0; e<sizeof( _entries ) / sizeof( _entries[0] ); e++ )
+        {
+            // Every entry point starts from the same state
+            if( _setup( &_inputs[k] ) )
+            {
+                fprintf( stderr, "Init failed\n" );
+                return 2;
+            }
+            _measure( &_entries[e], &ns, &cycles, &iterations );
+
+            fprintf( out, "{\"function\":\"%s\",\"input\":\"%s\",\"bufSize\":%lu,\"ns\":%.3f,"
+                          "\"cycles\":%.1f,\"iterations\":%lu}\n",
+                     _entries[e].name, _inputs[k].name, (unsigned long)WIND_VANE_ADC_BUF_SIZE,
+                     ns, cycles, (unsigned long)iterations );
+
+            base = _findBaseline( _entries[e].name, _inputs[k].name );
+            if( base != NULL )
+            {
+                limit = base->ns * ( 1.0 + threshold / 100.0 ) + slack;
+                if( ns > limit )
+                {
+                    fprintf( stderr, "Regression: %s (%s, %lu samples) %.3f ns, baseline %.3f ns, limit %.3f ns\n",
+                             _entries[e].name, _inputs[k].name, (unsigned long)WIND_VANE_ADC_BUF_SIZE,
+                             ns, base->ns, limit );
+                    regressions++;
+                }
+            }
+        }
+    }
+
+    if( out != stdout )
+    {
+        fclose( out );
+    }
+    return( ( regressions != 0 ) ? 1 : 0 );
+}
+
+// End of file - weatherMeterBench.c
@@ -0,0 +1,310 @@
+/** @file weatherMeterSim.c
+*
+* @brief    Simulates the Sparkfun Weather Meters on the host HAL
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "weatherMeterSim.h"
+#include <string.h>
+
+/**
+ * @brief   Progress towards one anemometer pulse, a ms at 1 cMPH adds
+ *          10 milli-MPH of WIND_SPEED_MILLI_MPH per pulse per second
+ */
+#define SIM_WIND_PULSE ( WIND_SPEED_MILLI_MPH * 1000ULL )
+/**
+ * @brief   Progress towards one rain bucket tip, a ms at 1 milli-in/hr
+ *          adds 1 of RAIN_BUCKET_MILLI_INCH per tip per hour
+ */
+#define SIM_RAIN_TIP ( RAIN_BUCKET_MILLI_INCH * 3600000ULL )
+/**
+ * @brief   The highest ADC code
+ */
+#define SIM_ADC_MAX ( ( 1L << WIND_VANE_ADC_BITS ) - 1 )
+
+/**
+ * @brief   Small xorshift generator for the ADC noise, the same trace
+ *          always gives the same samples
+ * @param   sim - The simulator
+ * @retval  The next random number
+ */
+static uint32_t _random( weatherSim_t *sim )
+{
+    uint32_t x = sim->rng;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return x;
+}
+
+/**
+ * @brief   Converts one wind vane sample into the ADC DMA buffer, and
+ *          calls the HAL callbacks at the half and end of it
+ * @param   sim - The simulator
+ * @param   seg - The segment playing
+ * @retval  None
+ */
+static void _convertWindVane( weatherSim_t *sim, const weatherSimSegment_t *seg )
+{
+    int32_t code;
+
+    if( seg->direction < WIND_VANE_DIRECTIONS_COUNT )
+    {
+        code = (int32_t)WIND_VANE_VALUES[seg->direction] + seg->offset;
+    }
+    else
+    {   // Nothing pulls the input down
+        code = SIM_ADC_MAX;
+    }
+    if( seg->noise != 0 )
+    {
+        code += (int32_t)( _random( sim ) % ( 2UL * seg->noise + 1 ) ) - seg->noise;
+    }
+    if( code < 0 )
+    {
+        code = 0;
+    }
+    else if( code > SIM_ADC_MAX )
+    {
+        code = SIM_ADC_MAX;
+    }
+
+    ( (windVaneSample_t *)sim->hadc.DmaBuffer )[sim->adcPos] = (windVaneSample_t)code;
+    sim->adcPos++;
+    if( sim->adcPos == sim->hadc.DmaLength / 2 )
+    {
+        HAL_ADC_ConvHalfCpltCallback( &sim->hadc );
+    }
+    else if( sim->adcPos == sim->hadc.DmaLength )
+    {   // Circular, start over
+        sim->adcPos = 0;
+        HAL_ADC_ConvCpltCallback( &sim->hadc );
+    }
+}
+
+/**
+ * @brief   Stamps one anemometer pulse into the capture DMA ring
+ * @param   sim - The simulator
+ * @param   num - How far into the ms the pulse is, over den
+ * @param   den - The progress made in the ms
+ * @retval  None
+ */
+static void _captureWindSpeed( weatherSim_t *sim, uint64_t num, uint64_t den )
+{
+    DMA_HandleTypeDef *hdma = &sim->captureDma;
+    uint64_t ticks = ( ( sim->ms - 1 ) * WIND_SPEED_CAPTURE_TICK_HZ ) / 1000 +
+                     ( num * WIND_SPEED_CAPTURE_TICK_HZ ) / ( den * 1000 );
+
+    ( (uint16_t *)hdma->Buffer )[hdma->Length - hdma->Instance->CNDTR] = (uint16_t)ticks;
+    hdma->Instance->CNDTR--;
+    if( hdma->Instance->CNDTR == 0 )
+    {   // Circular, start over
+        hdma->Instance->CNDTR = hdma->Length;
+    }
+}
+
+/**
+ * @brief   Counts pulses into a simulated counter, setting its update
+ *          flag when it wraps
+ * @param   tim - The counter
+ * @param   pulses - The pulses
+ * @retval  None
+ */
+static void _count( TIM_TypeDef *tim, uint32_t pulses )
+{
+    uint32_t cnt = tim->CNT + pulses;
+
+    if( cnt > tim->ARR )
+    {
+        tim->SR |= TIM_SR_UIF;
+    }
+    tim->CNT = cnt & tim->ARR;
+}
+
+/**
+ * @brief   Moves the anemometer on by a ms
+ * @param   sim - The simulator
+ * @param   seg - The segment playing
+ * @retval  None
+ */
+static void _stepWindSpeed( weatherSim_t *sim, const weatherSimSegment_t *seg )
+{
+    uint64_t inc = (uint64_t)seg->windCMPH * 10;
+    uint32_t pulses = 0;
+    uint32_t i;
+
+    sim->windPhase += inc;
+    while( sim->windPhase >= SIM_WIND_PULSE )
+    {
+        sim->windPhase -= SIM_WIND_PULSE;
+        pulses++;
+    }
+    if( pulses == 0 )
+    {
+        return;
+    }
+
+    if( sim->captureDma.Buffer != NULL )
+    {   // The pulses crossed the threshold at even steps through the ms
+        for( i=0; i<pulses; i++ )
+        {
+            _captureWindSpeed( sim, inc - sim->windPhase - ( pulses - 1 - i ) * SIM_WIND_PULSE, inc );
+        }
+    }
+    else if( sim->windTimer.Running )
+    {
+        _count( &sim->windTim, pulses );
+    }
+}
+
+/**
+ * @brief   Moves the rain bucket on by a ms
+ * @param   sim - The simulator
+ * @param   seg - The segment playing
+ * @retval  None
+ */
+static void _stepRainBucket( weatherSim_t *sim, const weatherSimSegment_t *seg )
+{
+    sim->rainPhase += seg->rainMilliInPerHr;
+    while( sim->rainPhase >= SIM_RAIN_TIP )
+    {
+        sim->rainPhase -= SIM_RAIN_TIP;
+        if( sim->rainTimer.Running )
+        {
+            _count( &sim->rainTim, 1 );
+        }
+        HAL_GPIO_EXTI_Callback( WEATHER_SIM_RAIN_PIN );
+    }
+}
+
+int8_t weatherSimInit( weatherSim_t *sim, const weatherSimSegment_t *trace,
+                       uint32_t segments, uint8_t loop )
+{
+    if( ( sim == NULL ) || ( trace == NULL ) || ( segments == 0 ) )
+    {
+        return 1;
+    }
+
+    memset( sim, 0, sizeof( *sim ) );
+    sim->hadc.Instance = &sim->adc;
+    sim->windTim.ARR = ( 1UL << WEATHER_METER_COUNTER_BITS ) - 1;
+    sim->rainTim.ARR = ( 1UL << WEATHER_METER_COUNTER_BITS ) - 1;
+    sim->windTimer.Instance = &sim->windTim;
+    sim->rainTimer.Instance = &sim->rainTim;
+    sim->captureDma.Instance = &sim->captureChannel;
+    sim->windTimer.hdma[TIM_DMA_ID_CC1] = &sim->captureDma;
+    sim->trace = trace;
+    sim->segments = segments;
+    sim->loop = loop;
+    sim->rng = 0x2545F491;
+
+    halHostSetTick( 0 );
+    return 0;
+}
+
+int8_t weatherSimRun( weatherSim_t *sim, uint32_t ms, uint8_t tick )
+{
+    const weatherSimSegment_t *seg;
+    uint32_t i;
+
+    while( ms-- > 0 )
+    {
+        // Skip to a segment with some length
+        while( ( sim->segment < sim->segments ) &&
+               ( sim->segmentMs >= sim->trace[sim->segment].ms ) )
+        {
+            sim->segment++;
+            sim->segmentMs = 0;
+            if( ( sim->segment == sim->segments ) && sim->loop )
+            {
+                sim->segment = 0;
+            }
+        }
+        seg = weatherSimSegment( sim );
+        if( seg == NULL )
+        {   // The trace has ended
+            return 1;
+        }
+
+        sim->ms++;
+        sim->segmentMs++;
+        if( tick )
+        {
+            halHostSetTick( HAL_GetTick() + 1 );
+        }
+
+        if( sim->hadc.Running )
+        {
+            for( i=0; i<WEATHER_SIM_ADC_SAMPLES_PER_MS; i++ )
+            {
+                _convertWindVane( sim, seg );
+            }
+        }
+        _stepWindSpeed( sim, seg );
+        _stepRainBucket( sim, seg );
+    }
+
+    return 0;
+}
+
+const weatherSimSegment_t* weatherSimSegment( const weatherSim_t *sim )
+{
+    if( sim->segment >= sim->segments )
+    {
+        return NULL;
+    }
+    return &sim->trace[sim->segment];
+}
+
+uint32_t weatherSimLoadTrace( FILE *file, weatherSimSegment_t *trace, uint32_t max )
+{
+    char line[128];
+    unsigned long ms, cmph, rain;
+    unsigned int dir, noise;
+    int offset;
+    uint32_t count = 0;
+
+    while( ( count < max ) && ( fgets( line, sizeof( line ), file ) != NULL ) )
+    {
+        const char *p = line + strspn( line, " \t" );
+
+        if( ( *p == '#' ) || ( *p == '\n' ) || ( *p == '\r' ) || ( *p == '\0' ) )
+        {
+            continue;
+        }
+        if( ( sscanf( p, "%lu %u %d %u %lu %lu", &ms, &dir, &offset, &noise, &cmph, &rain ) != 6 ) ||
+            ( dir > WEATHER_SIM_VANE_OPEN ) || ( offset < INT16_MIN ) || ( offset > INT16_MAX ) ||
+            ( noise > UINT16_MAX ) )
+        {   // Not a segment
+            return 0;
+        }
+        trace[count].ms = (uint32_t)ms;
+        trace[count].direction = (uint8_t)dir;
+        trace[count].offset = (int16_t)offset;
+        trace[count].noise = (uint16_t)noise;
+        trace[count].windCMPH = (uint32_t)cmph;
+        trace[count].rainMilliInPerHr = (uint32_t)rain;
+        count++;
+    }
+
+    return count;
+}
+
+// End of file - weatherMeterSim.c
@@ -0,0 +1,143 @@
+/** @file weatherMeterSim.h
+*
+* @brief    Simulates the Sparkfun Weather Meters on the host HAL.  A trace
+*           of segments sets the wind direction, wind speed and rain rate,
+*           and the simulator turns it into ADC samples in the wind vane
+*           DMA buffer, anemometer and rain bucket counts in the timer
+*           counters (or capture DMA ring) and rain bucket pin interrupts
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef _weatherMeterSim_H
+#define _weatherMeterSim_H
+
+#include <stdio.h>
+#include "weatherMeter.h"
+
+/**
+ * @brief   WEATHER_SIM_ADC_SAMPLES_PER_MS - the wind vane conversions per
+ *          millisecond the ADC is modelled with
+ */
+#ifndef WEATHER_SIM_ADC_SAMPLES_PER_MS
+#define WEATHER_SIM_ADC_SAMPLES_PER_MS 4
+#endif
+
+/**
+ * @brief   WEATHER_SIM_RAIN_PIN - the pin passed to HAL_GPIO_EXTI_Callback()
+ *          for a rain bucket tip
+ */
+#ifndef WEATHER_SIM_RAIN_PIN
+#define WEATHER_SIM_RAIN_PIN 0x0001
+#endif
+
+/**
+ * @brief   WEATHER_SIM_VANE_OPEN - the direction of a segment with the vane
+ *          disconnected, the pull-up takes the ADC to full scale
+ */
+#define WEATHER_SIM_VANE_OPEN WIND_VANE_DIRECTIONS_COUNT
+
+/**
+ * @brief   One segment of a trace, the conditions are held for its length
+ */
+typedef struct
+{
+    uint32_t ms;                    // length of the segment
+    uint8_t direction;              // windVaneDir_t or WEATHER_SIM_VANE_OPEN
+    int16_t offset;                 // ADC codes added to the direction's value
+    uint16_t noise;                 // peak ADC noise, uniform around the value
+    uint32_t windCMPH;              // wind speed in hundredths of a MPH
+    uint32_t rainMilliInPerHr;      // rain rate in thousandths of an inch per hour
+} weatherSimSegment_t;
+
+/**
+ * @brief   The simulated hardware of a station and where it is in its
+ *          trace.  Hand the handles to the library's init functions
+ */
+typedef struct
+{
+    ADC_HandleTypeDef hadc;         // wind vane ADC
+    TIM_HandleTypeDef windTimer;    // anemometer counter or capture timer
+    TIM_HandleTypeDef rainTimer;    // rain bucket counter
+    TIM_TypeDef windTim;
+    TIM_TypeDef rainTim;
+    DMA_HandleTypeDef captureDma;
+    DMA_Channel_TypeDef captureChannel;
+    ADC_TypeDef adc;
+
+    const weatherSimSegment_t *trace;
+    uint32_t segments;
+    uint8_t loop;                   // start over at the end of the trace
+    uint32_t segment;               // segment playing
+    uint32_t segmentMs;             // time spent in it
+
+    uint64_t ms;                    // time since weatherSimInit()
+    uint32_t adcPos;                // next DMA transfer
+    uint64_t windPhase;             // progress towards the next pulse
+    uint64_t rainPhase;
+    uint32_t rng;
+} weatherSim_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Sets up the simulated hardware and the trace, and resets the
+ *          host tick
+ * @param   sim - The simulator
+ * @param   trace - The segments to play, kept by reference
+ * @param   segments - The number of segments
+ * @param   loop - 1 to start over at the end of the trace
+ * @retval  0 on success, 1 on failure
+ */
+int8_t weatherSimInit( weatherSim_t *sim, const weatherSimSegment_t *trace,
+                       uint32_t segments, uint8_t loop );
+/**
+ * @brief   Moves the simulation on by some milliseconds, one at a time.
+ *          The host tick is advanced, and the HAL callbacks are called
+ *          as the ADC DMA buffer fills and the rain bucket tips.  Several
+ *          simulators share the host tick, run them in lock step and
+ *          advance it from one of them only
+ * @param   sim - The simulator
+ * @param   ms - The milliseconds to run for
+ * @param   tick - 1 to advance the host tick
+ * @retval  0 while the trace plays, 1 once it has ended
+ */
+int8_t weatherSimRun( weatherSim_t *sim, uint32_t ms, uint8_t tick );
+/**
+ * @brief   Returns the segment being played
+ * @param   sim - The simulator
+ * @retval  The segment, NULL once the trace has ended
+ */
+const weatherSimSegment_t* weatherSimSegment( const weatherSim_t *sim );
+/**
+ * @brief   Reads a trace from a text file, one segment per line as
+ *          "ms direction offset noise windCMPH rainMilliInPerHr".  Blank
+ *          lines and lines starting with # are skipped
+ * @param   file - The file to read
+ * @param   trace - Where to put the segments
+ * @param   max - The room in trace
+ * @retval  The number of segments read, 0 on failure
+ */
+uint32_t weatherSimLoadTrace( FILE *file, weatherSimSegment_t *trace, uint32_t max );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _weatherMeterSim_H */
@@ -0,0 +1,217 @@
+/** @file weatherMeterSimDemo.c
+*
+* @brief    Runs the weather meter library against the simulator on the
+*           host and prints the readings once a minute.  Plays the trace
+*           file given on the command line, or a built in passing shower
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+#include "weatherMeterSim.h"
+
+#define DEMO_MAX_SEGMENTS 256
+
+/**
+ * @brief   A shower passing through: a calm start, the wind backing and
+ *          picking up ahead of the rain, a squall fast enough to lap the
+ *          capture ring, a vane reading on a band edge and an open vane
+ */
+static const weatherSimSegment_t _shower[] =
+{
+    //  ms      direction   offset  noise   cMPH    milli-in/hr
+    {  600000, N,                0,     4,      0,      0 },
+    {  600000, NW,               0,     8,    450,      0 },
+    {  300000, W,                0,    12,   1200,    250 },
+    {  600000, WSW,              0,    16,   2400,   1500 },
+    {  120000, WSW,              0,    16,  10000,   3000 },
+    {  300000, SW,              20,     6,   1600,    500 },
+    {  120000, WEATHER_SIM_VANE_OPEN, 0, 0,   900,      0 },
+    {  600000, SW,               0,     4,    700,      0 },
+};
+
+static weatherSimSegment_t _trace[DEMO_MAX_SEGMENTS];
+static weatherSim_t _sim;
+
+#if !WIND_VANE_DOUBLE_BUFFER
+void HAL_ADC_ConvCpltCallback( ADC_HandleTypeDef *hadc )
+{
+    (void)hadc;
+    processWindVane();
+}
+#elif !WIND_VANE_HAL_CALLBACKS
+void HAL_ADC_ConvHalfCpltCallback( ADC_HandleTypeDef *hadc )
+{
+    (void)hadc;
+    processWindVaneFirstHalf();
+}
+
+void HAL_ADC_ConvCpltCallback( ADC_HandleTypeDef *hadc )
+{
+    (void)hadc;
+    processWindVaneSecondHalf();
+}
+#endif /* WIND_VANE_DOUBLE_BUFFER */
+
+#if WEATHER_METER_PROFILE
+static const char *_profileNames[WEATHER_PROFILE_COUNT] =
+{
+    "processWindVane",
+    "processWindVaneHalf",
+    "getWindVaneDirection",
+    "getWindVaneDirString",
+    "processWindSpeed",
+    "getWindSpeed",
+    "rainBucketTip",
+    "processRainBucket",
+    "getRainfall",
+};
+
+/**
+ * @brief   The profile clock on the host, the monotonic clock in ns
+ * @param   None
+ * @retval  The clock
+ */
+static uint32_t _hostNs( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint32_t)( (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec );
+}
+
+/**
+ * @brief   Prints the times of the functions called
+ * @param   None
+ * @retval  None
+ */
+static void _printProfile( void )
+{
+    weatherProfile_t profile;
+    uint32_t id;
+
+    fprintf( stderr, "function,count,min_ns,mean_ns,max_ns\n" );
+    for( id=0; id<WEATHER_PROFILE_COUNT; id++ )
+    {
+        if( ( getWeatherProfile( (weatherProfileId_t)id, &profile ) == 0 ) && ( profile.count != 0 ) )
+        {
+            fprintf( stderr, "%s,%lu,%lu,%lu,%lu\n", _profileNames[id], (unsigned long)profile.count,
+                     (unsigned long)profile.min, (unsigned long)profile.mean, (unsigned long)profile.max );
+        }
+    }
+}
+#endif /* WEATHER_METER_PROFILE */
+
+#if RAIN_BUCKET_TIPS
+void HAL_GPIO_EXTI_Callback( uint16_t GPIO_Pin )
+{
+    if( GPIO_Pin == WEATHER_SIM_RAIN_PIN )
+    {
+        rainBucketTip();
+    }
+}
+#endif /* RAIN_BUCKET_TIPS */
+
+int main( int argc, char *argv[] )
+{
+    const weatherSimSegment_t *trace = _shower;
+    uint32_t segments = sizeof( _shower ) / sizeof( _shower[0] );
+    uint8_t dir[4];
+    uint32_t ms = 0;
+    uint32_t speed;
+    uint32_t rain;
+#if WEATHER_METER_SNAPSHOT
+    stationSnapshot_t snapshot;
+#endif
+    FILE *file;
+
+    if( argc > 1 )
+    {   // Play the trace from the file instead
+        file = fopen( argv[1], "r" );
+        if( file == NULL )
+        {
+            fprintf( stderr, "Can't open %s\n", argv[1] );
+            return 1;
+        }
+        segments = weatherSimLoadTrace( file, _trace, DEMO_MAX_SEGMENTS );
+        fclose( file );
+        if( segments == 0 )
+        {
+            fprintf( stderr, "No trace in %s\n", argv[1] );
+            return 1;
+        }
+        trace = _trace;
+    }
+
+    if( weatherSimInit( &_sim, trace, segments, 0 ) ||
+        initWindVane( &_sim.hadc ) ||
+#if WIND_SPEED_CAPTURE
+        initWindSpeedCapture( &_sim.windTimer, TIM_CHANNEL_1 ) ||
+#else
+        initWindSpeed( &_sim.windTimer ) ||
+#endif
+#if RAIN_BUCKET_TIPS
+        initRainBucketTips() )
+#else
+        initRainBucket( &_sim.rainTimer ) )
+#endif
+    {
+        fprintf( stderr, "Init failed\n" );
+        return 1;
+    }
+
+#if WEATHER_METER_PROFILE
+    setWeatherProfileClock( _hostNs, 1000000000UL );
+#endif
+
+    printf( "minute,direction,wind_cMPH,rain_milliInPerHr\n" );
+    while( weatherSimRun( &_sim, 1, 1 ) == 0 )
+    {
+        ms++;
+        if( ms % 1000 == 0 )
+        {
+            processWindSpeed();
+        }
+        if( ms % 60000 == 0 )
+        {
+            processRainBucket();
+#if WEATHER_METER_SNAPSHOT
+            // All three readings from the same generation
+            getStationSnapshot( &snapshot );
+            getWindVaneDirString( snapshot.direction, dir );
+            speed = snapshot.windSpeed_cMPH;
+            rain = snapshot.rainfall_milliInPerHr;
+#else
+            getWindVaneDirString( getWindVaneDirection(), dir );
+            speed = getWindSpeed_cMPH();
+            rain = getRainfall_milliInPerHr();
+#endif
+            printf( "%lu,%s,%lu,%lu\n", (unsigned long)( ms / 60000 ), (const char *)dir,
+                    (unsigned long)speed, (unsigned long)rain );
+        }
+    }
+
+#if WEATHER_METER_PROFILE
+    _printProfile();
+#endif
+    return 0;
+}
+
+// End of file - weatherMeterSimDemo.c
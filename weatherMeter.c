@@ -29,6 +29,16 @@
 #include "stm32f1xx_hal.h"
 #endif
 
+#ifndef __ALIGNED
+#define __ALIGNED( x ) __attribute__( ( aligned( x ) ) )
+#endif
+
+/**
+ * @brief   WEATHER_METER_BARRIER - keeps the data shared with an ISR
+ *          written before the index or counter that publishes it
+ */
+#define WEATHER_METER_BARRIER() __sync_synchronize()
+
 /**
  * @brief Wind Vane Direction Strings.  E, NE, SSE, etc.
  */
@@ -68,52 +78,522 @@ uint32_t WIND_VANE_VALUES[WIND_VANE_DIRECTIONS_COUNT] = {       3541,
                                                                 3762,
                                                                 3341 };
 
+#if WIND_VANE_AUTOCAL
+/**
+ * @brief   WIND_VANE_AUTOCAL_FRAC_BITS - fractional bits the values are
+ *          tracked with while they are adjusted
+ */
+#define WIND_VANE_AUTOCAL_FRAC_BITS 8
+#endif
+
+#if WIND_VANE_VECTOR_AVG || WEATHER_ROLLUP
+/**
+ * @brief   Sine of each direction in Q15, the cosine is 4 directions on
+ */
+static const int16_t WIND_VANE_SIN_Q15[WIND_VANE_DIRECTIONS_COUNT] = {      0,
+                                                                        12540,
+                                                                        23170,
+                                                                        30273,
+                                                                        32767,
+                                                                        30273,
+                                                                        23170,
+                                                                        12540,
+                                                                            0,
+                                                                       -12540,
+                                                                       -23170,
+                                                                       -30273,
+                                                                       -32767,
+                                                                       -30273,
+                                                                       -23170,
+                                                                       -12540 };
+#endif /* WIND_VANE_VECTOR_AVG || WEATHER_ROLLUP */
+
+/**
+ * @brief   The station the functions without a station argument work on
+ */
+static weatherMeter_t _weatherMeter = WEATHER_METER_INIT( _weatherMeter );
+
+#if WEATHER_METER_PROFILE
+/**
+ * @brief   The times of one function, published like the gust state.
+ *          Its writers take WEATHER_METER_LOCK so they don't mix
+ */
+typedef struct
+{
+    volatile uint32_t updates;          // Odd while the times are written
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t histogram[WEATHER_METER_PROFILE_BINS];
+} weatherProfileEntry_t;
+
+/**
+ * @brief   The profile of all functions, shared by the stations
+ */
+static struct
+{
+    weatherMeterClock_t clock;
+    uint32_t hz;
+    weatherProfileEntry_t entries[WEATHER_PROFILE_COUNT];
+} _profile = { HAL_GetTick, 1000, { { 0 } } };
+
+/**
+ * @brief   WEATHER_METER_LOCK / WEATHER_METER_UNLOCK - keep an update of
+ *          the profile from being interrupted half way, as the same
+ *          function is timed from the main loop, ISRs and stations at
+ *          other priorities.  Cortex-M masks interrupts, the host has
+ *          none and its threads take turns on a flag.  Define both to use
+ *          an RTOS's critical sections instead
+ */
+#ifndef WEATHER_METER_LOCK
+#if defined( __CORTEX_M )
+#define WEATHER_METER_LOCK( key )   do { ( key ) = __get_PRIMASK(); __disable_irq(); } while( 0 )
+#define WEATHER_METER_UNLOCK( key ) __set_PRIMASK( key )
+#else
+static volatile uint32_t _profileLock;
+#define WEATHER_METER_LOCK( key )   do { ( key ) = 0; while( __sync_lock_test_and_set( &_profileLock, 1 ) ) {} } while( 0 )
+#define WEATHER_METER_UNLOCK( key ) do { (void)( key ); __sync_lock_release( &_profileLock ); } while( 0 )
+#endif
+#endif /* WEATHER_METER_LOCK */
+
+#if defined( DWT_CTRL_CYCCNTENA_Msk ) && defined( CoreDebug_DEMCR_TRCENA_Msk )
+/**
+ * @brief   Reads the DWT cycle counter
+ * @param   None
+ * @retval  The cycles
+ */
+static uint32_t _profileCycles( void )
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+/**
+ * @brief   Adds a call to the times of a function
+ * @param   id - The function
+ * @param   start - The profile clock when the call started
+ * @retval  None
+ */
+static void _profileRecord( weatherProfileId_t id, uint32_t start )
+{
+    uint32_t ticks = _profile.clock() - start;
+    weatherProfileEntry_t *p = &_profile.entries[id];
+    uint32_t bin = ( ticks > 1 ) ? ( 31 - (uint32_t)__builtin_clz( ticks ) ) : 0;
+    uint32_t key;
+
+    if( bin >= WEATHER_METER_PROFILE_BINS )
+    {
+        bin = WEATHER_METER_PROFILE_BINS - 1;
+    }
+
+    WEATHER_METER_LOCK( key );
+    p->updates++;
+    WEATHER_METER_BARRIER();
+    if( ( p->count == 0 ) || ( ticks < p->min ) )
+    {
+        p->min = ticks;
+    }
+    if( ticks > p->max )
+    {
+        p->max = ticks;
+    }
+    p->count++;
+    p->total += ticks;
+    p->histogram[bin]++;
+    WEATHER_METER_BARRIER();
+    p->updates++;
+    WEATHER_METER_UNLOCK( key );
+}
+
+/**
+ * @brief   WEATHER_PROFILE_BEGIN / WEATHER_PROFILE_END - time the code
+ *          between them as a call of a function
+ */
+#define WEATHER_PROFILE_BEGIN()     uint32_t _profileStart = _profile.clock()
+#define WEATHER_PROFILE_END( id )   _profileRecord( ( id ), _profileStart )
+#else
+#define WEATHER_PROFILE_BEGIN()
+#define WEATHER_PROFILE_END( id )
+#endif /* WEATHER_METER_PROFILE */
+
+/**
+ * @brief   WEATHER_SNAPSHOT_BEGIN / WEATHER_SNAPSHOT_END - publish the
+ *          readings written between them under a sequence counter
+ */
+#if WEATHER_METER_SNAPSHOT
+#define WEATHER_SNAPSHOT_BEGIN( seq )   do { ( seq )++; WEATHER_METER_BARRIER(); } while( 0 )
+#define WEATHER_SNAPSHOT_END( seq )     do { WEATHER_METER_BARRIER(); ( seq )++; } while( 0 )
+#else
+#define WEATHER_SNAPSHOT_BEGIN( seq )
+#define WEATHER_SNAPSHOT_END( seq )
+#endif /* WEATHER_METER_SNAPSHOT */
+
+/**
+ * @brief   Returns the time of a station in milliseconds, for timestamps,
+ *          windows and timeouts.  It's the station clock when that counts
+ *          milliseconds, so a test clock drives all of them, and
+ *          HAL_GetTick() otherwise as a faster clock wraps too soon
+ * @param   wm - The station
+ * @retval  The time in milliseconds
+ */
+static inline uint32_t _nowMs( weatherMeter_t *wm )
+{
+    return( ( wm->clockHz == 1000 ) ? wm->clock() : HAL_GetTick() );
+}
+
+#if WEATHER_METER_EVENTS
+/**
+ * @brief   Pushes an event, from the queue's producer only
+ * @param   wm - The station
+ * @param   queue - The queue to push to
+ * @param   type - The kind of event
+ * @param   value - The event value
+ * @retval  None
+ */
+static void _pushEvent( weatherMeter_t *wm, weatherEventQueueId_t queue,
+                        weatherEventType_t type, uint32_t value )
+{
+    weatherEventQueue_t *q = &wm->eventQueues[queue];
+    uint32_t head = q->head;
+    weatherEvent_t *event;
+
+    if( head - q->tail >= WEATHER_METER_EVENT_QUEUE_SIZE )
+    {   // Full, keep what's queued and count the loss
+        q->drops++;
+        return;
+    }
+
+    event = &q->ring[head & ( WEATHER_METER_EVENT_QUEUE_SIZE - 1 )];
+    event->timestamp = _nowMs( wm );
+    event->value = value;
+    event->type = type;
+
+    // Publish the event only once it's all written
+    WEATHER_METER_BARRIER();
+    q->head = head + 1;
+}
+#endif /* WEATHER_METER_EVENTS */
+
+/**
+ * @brief   Returns the milliseconds since the previous call for the same
+ *          time, by the clock set with setWeatherMeterClock()
+ * @param   wm - The station
+ * @param   last - The clock at the previous call, updated
+ * @retval  The elapsed milliseconds
+ */
+static uint32_t _elapsedMs( weatherMeter_t *wm, uint32_t *last )
+{
+    uint32_t now = wm->clock();
+    uint32_t elapsed = now - *last;
+
+    *last = now;
+    if( wm->clockHz == 1000 )
+    {   // HAL_GetTick(), no conversion
+        return elapsed;
+    }
+    return( (uint32_t)( ( (uint64_t)elapsed * 1000 + wm->clockHz / 2 ) / wm->clockHz ) );
+}
+
+#if WEATHER_METER_HEALTH
 /**
- * @brief   A Handle to the ADC that will be making the wind vane readings
- *          This ADC needs to be configured to do a DMA transfer and an
- *          appropriate buffer allocated with size WIND_VANE_ADC_BUF_SIZE
+ * @brief   Counts a late call and the periods missed before it
+ * @param   ms - The milliseconds since the previous call
+ * @param   period - The milliseconds expected between calls
+ * @param   late - The late calls, updated
+ * @param   missed - The periods missed, updated
+ * @retval  None
  */
-ADC_HandleTypeDef* hwindVaneAdc;
+static void _healthCadence( uint32_t ms, uint32_t period, uint32_t *late, uint32_t *missed )
+{
+    if( ms > period + period * WEATHER_METER_HEALTH_LATE_PERCENT / 100 )
+    {
+        ( *late )++;
+    }
+    if( ms >= 2 * period )
+    {   // Whole periods went by without a call
+        *missed += ms / period - 1;
+    }
+}
+
+#if !( WIND_SPEED_CAPTURE && RAIN_BUCKET_TIPS )
 /**
- * @brief   The ADC Buffer
+ * @brief   Counts a wrap of a counter that lost pulses, from its update
+ *          flag.  A reading taken since the previous one with the counter
+ *          below where it was is the one wrap a free running difference
+ *          handles, anything else went a whole period further.  The one
+ *          flag can't tell more wraps past the one handled, so with
+ *          WEATHER_METER_FREE_RUNNING the count is a lower bound
+ * @param   htim - The handle of the timer acting as the counter
+ * @param   count - The pulses taken from the counter
+ * @param   cnt - The counter as it was read
+ * @param   wraps - The wraps, updated
+ * @retval  None
  */
-uint32_t _adcBuf[WIND_VANE_ADC_BUF_SIZE];
+static void _healthWrap( TIM_HandleTypeDef *htim, uint32_t count, uint32_t cnt, uint32_t *wraps )
+{
+    if( __HAL_TIM_GET_FLAG( htim, TIM_FLAG_UPDATE ) )
+    {   // At least once since the last look
+        __HAL_TIM_CLEAR_FLAG( htim, TIM_FLAG_UPDATE );
+        if( count <= cnt )
+        {   // Not from where the previous reading left it
+            ( *wraps )++;
+        }
+    }
+}
+#endif
+
 /**
- * @brief   A holder for the average of the ADC buffer
+ * @brief   Counts the wind vane buffers overwritten before this one was
+ *          processed
+ * @param   wm - The station
+ * @param   half - The half processed, 1 or 2, 0 for the whole buffer
+ * @retval  None
  */
-static volatile uint32_t _average;
+static void _healthWindVane( weatherMeter_t *wm, uint8_t half )
+{
+    uint32_t done = wm->health.vaneDone;
+
+    if( done != 0 )
+    {   // windVaneBufferDone() is called, all but the last are lost
+        if( done - wm->health.vaneSeen > 1 )
+        {
+            wm->health.counts.vaneOverruns += done - wm->health.vaneSeen - 1;
+        }
+        wm->health.vaneSeen = done;
+    }
+    else if( ( half != 0 ) && ( half == wm->health.vaneLastHalf ) )
+    {   // The other half went by unprocessed
+        wm->health.counts.vaneOverruns++;
+    }
+    wm->health.vaneLastHalf = half;
+}
+#endif /* WEATHER_METER_HEALTH */
+
+int8_t initWeatherMeter( weatherMeter_t *wm )
+{
+    if( wm == NULL )
+    {
+        return 1;
+    }
+    // Everything starts at 0 but for the same members WEATHER_METER_INIT sets
+    memset( wm, 0, sizeof( *wm ) );
+    wm->windVaneValues = WIND_VANE_VALUES;
+#if WIND_VANE_USE_LUT && !WIND_VANE_EXTERNAL_TABLES
+    wm->windVaneLut = wm->windVaneLutBuf;
+#endif
+#if WIND_VANE_VOTE
+    wm->vote = WIND_VANE_DIRECTIONS_COUNT;
+#endif
+#if WEATHER_METER_EVENTS && !WIND_VANE_DEBOUNCE
+    wm->lastDir = WIND_VANE_DIRECTIONS_COUNT;
+#endif
+    wm->windSpeedInterval = 1000;
+    wm->rainBucketInterval = 60000;
+    wm->clock = HAL_GetTick;
+    wm->clockHz = 1000;
+#if WIND_VANE_DEBOUNCE
+    wm->debounce.committed = WIND_VANE_DIRECTIONS_COUNT;
+    wm->debounce.candidate = WIND_VANE_DIRECTIONS_COUNT;
+#endif
+#if WEATHER_ROLLUP
+    wm->rollupSpeed.ring = wm->rollupSpeedRing;
+    wm->rollupSpeed.qty = 2;
+    wm->rollupSpeed.base = WEATHER_ROLLUP_LEVEL_SECONDS;
+    wm->rollupDir.ring = wm->rollupDirRing;
+    wm->rollupDir.qty = 3;
+    wm->rollupDir.base = WEATHER_ROLLUP_LEVEL_SECONDS;
+    wm->rollupRain.ring = wm->rollupRainRing;
+    wm->rollupRain.qty = 1;
+    wm->rollupRain.base = WEATHER_ROLLUP_LEVEL_MINUTES;
+#endif
+    return 0;
+}
+
+weatherMeter_t* getWeatherMeter( void )
+{
+    return &_weatherMeter;
+}
+
+int8_t wmSetWeatherMeterClock( weatherMeter_t *wm, weatherMeterClock_t clock, uint32_t hz )
+{
+    if( ( clock == NULL ) || ( hz == 0 ) )
+    {
+        return 1;
+    }
+    wm->clock = clock;
+    wm->clockHz = hz;
+    // Restart the intervals on the new clock
+    wm->windSpeedLastTime = clock();
+    wm->rainBucketLastTime = wm->windSpeedLastTime;
+    return 0;
+}
 
+#if WEATHER_ROLLUP
 /**
- * @brief   A Handle to the timer that will act as the counter for the
- *          anemometer
+ * @brief   Rollup ring sizes, each ring has one more snapshot than buckets
  */
-TIM_HandleTypeDef* hwindSpeedTimer;
+static const uint16_t _rollupSize[WEATHER_ROLLUP_LEVEL_COUNT] = { WEATHER_ROLLUP_SECONDS,
+                                                                  WEATHER_ROLLUP_MINUTES,
+                                                                  WEATHER_ROLLUP_HOURS,
+                                                                  WEATHER_ROLLUP_DAYS };
 /**
- * @brief   The raw count from the timer of the anemometer
+ * @brief   Buckets of the level below in a bucket of each level
  */
-static volatile uint32_t _windSpeedCount = 0;
+static const uint8_t _rollupRatio[WEATHER_ROLLUP_LEVEL_COUNT] = { 1, 60, 60, 24 };
 /**
- * @brief   The conversion factor from the datasheet to convert counts
- *          to MPH
+ * @brief   The milliseconds in a bucket of each level
  */
-const double windSpeedConversion_MPH = 1.492;
+static const uint32_t _rollupMs[WEATHER_ROLLUP_LEVEL_COUNT] = { 1000UL, 60000UL, 3600000UL, 86400000UL };
 
 /**
- * @brief   A Handle to the timer that will act as the counter for the
- *          rain bucket
+ * @brief   Returns the first snapshot of a level in a channel's ring
+ * @param   r - The channel
+ * @param   level - The level
+ * @retval  The snapshot index
  */
-TIM_HandleTypeDef* hrainBucketCounter;
+static uint32_t _rollupOffset( const weatherRollup_t *r, uint32_t level )
+{
+    uint32_t offset = 0;
+
+    for( uint32_t i=r->base; i<level; i++ )
+    {
+        offset += _rollupSize[i] + 1u;
+    }
+    return offset;
+}
+
+/**
+ * @brief   Closes base level buckets of a channel and cascades the
+ *          completed buckets up the levels.  No more than a ring of
+ *          snapshots is written per level, older ones would be
+ *          overwritten anyway, so a long gap costs no more than a short
+ *          one
+ * @param   r - The channel
+ * @param   buckets - The base level buckets to close
+ * @retval  None
+ */
+static void _rollupSnapshot( weatherRollup_t *r, uint32_t buckets )
+{
+    uint32_t offset = 0;
+    uint32_t steps = buckets;
+    uint32_t slots;
+    uint32_t writes;
+    uint32_t *snap;
+
+    for( uint32_t level=r->base; ( level < WEATHER_ROLLUP_LEVEL_COUNT ) && ( steps != 0 ); level++ )
+    {
+        if( level != r->base )
+        {   // Only as many as the buckets of the level below complete
+            steps += r->phase[level];
+            r->phase[level] = (uint8_t)( steps % _rollupRatio[level] );
+            steps /= _rollupRatio[level];
+        }
+
+        slots = _rollupSize[level] + 1u;
+        writes = ( steps < slots ) ? steps : slots;
+        // The buckets not written are empty like the ones that are
+        r->head[level] = (uint16_t)( ( r->head[level] + ( steps - writes ) % slots ) % slots );
+        for( uint32_t i=0; i<writes; i++ )
+        {
+            r->head[level] = (uint16_t)( ( r->head[level] + 1u ) % slots );
+            snap = &r->ring[( offset + r->head[level] ) * r->qty];
+            for( uint32_t q=0; q<r->qty; q++ )
+            {
+                snap[q] = r->total[q];
+            }
+        }
+        r->filled[level] = (uint16_t)( ( steps < (uint32_t)( _rollupSize[level] - r->filled[level] ) ) ?
+                                       ( r->filled[level] + steps ) : _rollupSize[level] );
+        offset += slots;
+    }
+}
+
 /**
- * @brief   The raw count from the timer of the rain bucket
+ * @brief   Adds to the totals of a channel and closes the base level
+ *          buckets the time passed, from the channel's producer only.
+ *          The amounts go into the newest bucket the time closes, or the
+ *          open one if it closes none.  The buckets before it are empty
+ * @param   r - The channel
+ * @param   add - The amounts to add to each total
+ * @param   ms - The milliseconds since the previous push
+ * @retval  None
  */
-static volatile uint32_t _rainBucketCount = 0;
+static void _rollupPush( weatherRollup_t *r, const uint32_t *add, uint32_t ms )
+{
+    uint32_t buckets;
+
+    // Odd while the state is changing, so readers can tell
+    r->updates++;
+    WEATHER_METER_BARRIER();
+
+    r->pendingMs += ms;
+    buckets = r->pendingMs / _rollupMs[r->base];
+    r->pendingMs %= _rollupMs[r->base];
+
+    if( buckets > 1 )
+    {   // The gap before the newest bucket
+        _rollupSnapshot( r, buckets - 1 );
+    }
+    for( uint32_t q=0; q<r->qty; q++ )
+    {
+        r->total[q] += add[q];
+    }
+    if( buckets != 0 )
+    {
+        _rollupSnapshot( r, 1 );
+    }
+
+    WEATHER_METER_BARRIER();
+    r->updates++;
+}
+
 /**
- * @brief   The conversion factor from the datasheet to convert counts
- *          to inches of rain per hour
+ * @brief   Totals the last completed buckets of a level of a channel
+ * @param   r - The channel
+ * @param   level - The level
+ * @param   buckets - The buckets to cover
+ * @param   out - An array of the channel's qty to store the totals
+ * @retval  The buckets covered, 0 if there are none
  */
-const double rainBucketConversion_inPerHr = 0.011;
+static uint32_t _rollupRead( const weatherRollup_t *r, uint32_t level,
+                             uint32_t buckets, uint32_t *out )
+{
+    uint32_t updates;
+    uint32_t slots;
+    uint32_t offset;
+    uint32_t n;
+    const uint32_t *newest;
+    const uint32_t *oldest;
+
+    if( ( level < r->base ) || ( level >= WEATHER_ROLLUP_LEVEL_COUNT ) ||
+        ( buckets == 0 ) || ( buckets > _rollupSize[level] ) )
+    {
+        return 0;
+    }
+    slots = _rollupSize[level] + 1u;
+    offset = _rollupOffset( r, level );
+
+    // Retry if the producer ran while reading
+    do
+    {
+        updates = r->updates;
+        WEATHER_METER_BARRIER();
+        n = ( buckets < r->filled[level] ) ? buckets : r->filled[level];
+        newest = &r->ring[( offset + r->head[level] ) * r->qty];
+        oldest = &r->ring[( offset + ( r->head[level] + slots - n ) % slots ) * r->qty];
+        for( uint32_t q=0; q<r->qty; q++ )
+        {
+            out[q] = newest[q] - oldest[q];
+        }
+        WEATHER_METER_BARRIER();
+    } while( ( updates & 1 ) || ( updates != r->updates ) );
+
+    return n;
+}
+#endif /* WEATHER_ROLLUP */
 
-int8_t initWindVane( ADC_HandleTypeDef* hadc )
+int8_t wmInitWindVane( weatherMeter_t *wm, ADC_HandleTypeDef* hadc )
 {
     if( hadc == NULL )
     {   // Something wrong with the ADC Handle
@@ -121,32 +601,51 @@ int8_t initWindVane( ADC_HandleTypeDef* hadc )
     }
     else
     {   // Grab a reference to the ADC handle and start the ADC
-        hwindVaneAdc = hadc;
-        HAL_ADC_Start_DMA( hadc, _adcBuf, WIND_VANE_ADC_BUF_SIZE );
+#if WIND_VANE_USE_LUT
+#if WIND_VANE_EXTERNAL_TABLES
+        if( wm->windVaneLut == NULL )
+        {   // setWindVaneTables() has to be called first
+            return 1;
+        }
+#else
+        wmBuildWindVaneLut( wm );
+#endif
+#endif
+#if WIND_VANE_AUTOCAL
+        wmResetWindVaneAutoCal( wm );
+#endif
+        wm->windVaneAdc = hadc;
+        HAL_ADC_Start_DMA( hadc, (uint32_t *)wm->adcBuf, WIND_VANE_ADC_BUF_SIZE );
         return 0;
     }
 }
 
-void processWindVane( void )
+/**
+ * @brief   Checks whether an ADC code is within the band of a direction
+ * @param   code - The ADC code
+ * @param   value - The ADC value of the direction
+ * @retval  1 if the code is in the band, 0 otherwise
+ */
+static inline uint8_t _inBand( uint32_t code, uint32_t value )
 {
-    _average = 0;
-
-    // Average the buffer
-    for( int i=0; i<WIND_VANE_ADC_BUF_SIZE; i++ )
-    {
-        _average += _adcBuf[i];
-    }
-    _average /= WIND_VANE_ADC_BUF_SIZE;
+    return( ( code + WIND_VANE_CODE_BAND >= value ) &&
+            ( code <= value + WIND_VANE_CODE_BAND ) );
 }
 
-windVaneDir_t getWindVaneDirection( void )
+#if !( WIND_VANE_USE_LUT && WIND_VANE_EXTERNAL_TABLES )
+/**
+ * @brief   Classifies an ADC code by scanning the values table
+ * @param   wm - The station
+ * @param   code - The ADC code
+ * @retval  The matching direction or WIND_VANE_DIRECTIONS_COUNT
+ */
+static windVaneDir_t _scanWindVane( weatherMeter_t *wm, uint32_t code )
 {
     // Run through the table of ADC values, applying a window and return the
     // one that matches
     for( int i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
     {
-        if( ( _average >= ( WIND_VANE_VALUES[i] - WIND_VANE_CODE_BAND ) ) &&
-            ( _average <= ( WIND_VANE_VALUES[i] + WIND_VANE_CODE_BAND ) ) )
+        if( _inBand( code, wm->windVaneValues[i] ) )
         {
             return( (windVaneDir_t)i );
         }
@@ -155,75 +654,2536 @@ windVaneDir_t getWindVaneDirection( void )
     // If this return is reached something has gone wrong
     return WIND_VANE_DIRECTIONS_COUNT;
 }
+#endif
 
-void getWindVaneDirString( windVaneDir_t direction, uint8_t *string )
+#if WIND_VANE_USE_LUT
+/**
+ * @brief   Classifies an ADC code with the lookup table
+ * @param   wm - The station
+ * @param   code - The ADC code
+ * @retval  The matching direction or WIND_VANE_DIRECTIONS_COUNT
+ */
+static inline windVaneDir_t _lookupWindVane( weatherMeter_t *wm, uint32_t code )
 {
-    if( direction < WIND_VANE_DIRECTIONS_COUNT )
-    {   // There's a valid direction
-        strcpy( (char *)string, (char *)WIND_VANE_DIR_STRING[direction] );
+    uint32_t dir;
+
+    if( code >= ( 1UL << WIND_VANE_ADC_BITS ) )
+    {   // Not a valid ADC code
+        return WIND_VANE_DIRECTIONS_COUNT;
     }
-    else if( direction == WIND_VANE_DIRECTIONS_COUNT )
-    {   // There's an error
-        strcpy( (char *)string, "ERR" );
+
+    dir = ( wm->windVaneLut[code >> 1] >> ( ( code & 1 ) << 2 ) ) & 0x0F;
+
+    // The table only holds 16 directions, codes outside every band are
+    // caught by checking the band of the direction found
+    if( _inBand( code, wm->windVaneValues[dir] ) )
+    {
+        return( (windVaneDir_t)dir );
     }
+    return WIND_VANE_DIRECTIONS_COUNT;
 }
 
-int8_t initWindSpeed( TIM_HandleTypeDef *htim )
+#if !WIND_VANE_EXTERNAL_TABLES
+/**
+ * @brief   Rebuilds part of the direction lookup table
+ * @param   wm - The station
+ * @param   first - The first pair of ADC codes to rebuild
+ * @param   count - The number of pairs to rebuild
+ * @retval  None
+ */
+static void _buildWindVaneLutSlice( weatherMeter_t *wm, uint32_t first, uint32_t count )
 {
-    if( htim == NULL )
-    {   // There's something wrong with the timer handle
-        return 1;
-    }
-    else
-    {   // Grab a reference to the timer and start it
-        hwindSpeedTimer = htim;
-        HAL_TIM_Base_Start( htim );
-        return 0;
+    windVaneDir_t even;
+    windVaneDir_t odd;
+
+    for( uint32_t i=first; i<first + count; i++ )
+    {
+        even = _scanWindVane( wm, i << 1 );
+        odd = _scanWindVane( wm, ( i << 1 ) | 1 );
+        // Codes in no band are stored as 0, the band check rejects them
+        wm->windVaneLutBuf[i] = (uint8_t)( ( ( even & 0x0F ) ) |
+                                        ( ( odd & 0x0F ) << 4 ) );
     }
 }
 
-void processWindSpeed( void )
+void wmBuildWindVaneLut( weatherMeter_t *wm )
 {
-    // Grab the current count from the timer
-    _windSpeedCount = hwindSpeedTimer->Instance->CNT;
-    // Clear it out
-    hwindSpeedTimer->Instance->CNT = 0;
+    _buildWindVaneLutSlice( wm, 0, WIND_VANE_LUT_SIZE );
+    wm->windVaneLut = wm->windVaneLutBuf;
 }
+#endif /* WIND_VANE_EXTERNAL_TABLES */
+#endif /* WIND_VANE_USE_LUT */
 
-uint32_t getWindSpeedCount( void )
+/**
+ * @brief   Classifies an ADC code with whichever method is configured
+ * @param   wm - The station
+ * @param   code - The ADC code
+ * @retval  The matching direction or WIND_VANE_DIRECTIONS_COUNT
+ */
+static inline windVaneDir_t _classifyWindVane( weatherMeter_t *wm, uint32_t code )
 {
-    return _windSpeedCount;
+#if WIND_VANE_USE_LUT
+    return _lookupWindVane( wm, code );
+#else
+    return _scanWindVane( wm, code );
+#endif
 }
 
-double getWindSpeed_MPH( void )
+#if WIND_VANE_DEBOUNCE
+/**
+ * @brief   Runs a reading through the debouncing
+ * @param   wm - The station
+ * @param   dir - The direction read, errors are ignored
+ * @retval  None
+ */
+static void _debounceWindVane( weatherMeter_t *wm, windVaneDir_t dir )
 {
-    return( windSpeedConversion_MPH * _windSpeedCount );
-}
+    uint32_t now = _nowMs( wm );
+    uint8_t commit;
 
-int8_t initRainBucket( TIM_HandleTypeDef *htim )
-{
-    if( htim == NULL )
-    {   // There's something wrong with the timer handle
-        return 1;
+    if( dir >= WIND_VANE_DIRECTIONS_COUNT )
+    {   // An error says nothing about where the vane is
+        return;
     }
-    else
-    {   // Grab a reference to the timer handle and start it
-        hrainBucketCounter = htim;
-        HAL_TIM_Base_Start( htim );
-        return 0;
+
+    if( dir == wm->debounce.committed )
+    {   // Back where we were, drop any pending change
+        wm->debounce.candidate = dir;
+        wm->debounce.count = 0;
+        return;
+    }
+
+    if( dir != wm->debounce.candidate )
+    {   // Start timing a new candidate
+        wm->debounce.candidate = dir;
+        wm->debounce.count = 0;
+        wm->debounce.since = now;
+    }
+    wm->debounce.count++;
+
+    // The first reading is taken straight away, after that the candidate
+    // has to last
+    commit = ( wm->debounce.committed == WIND_VANE_DIRECTIONS_COUNT );
+#if WIND_VANE_DEBOUNCE_COUNT
+    commit |= ( wm->debounce.count >= WIND_VANE_DEBOUNCE_COUNT );
+#endif
+#if WIND_VANE_DEBOUNCE_DWELL_MS
+    commit |= ( now - wm->debounce.since >= WIND_VANE_DEBOUNCE_DWELL_MS );
+#endif
+
+    if( commit )
+    {
+        wm->debounce.committed = dir;
+        wm->debounce.count = 0;
+        wm->debounce.changes++;
+#if WEATHER_METER_EVENTS
+        _pushEvent( wm, WEATHER_EVENT_QUEUE_VANE, WEATHER_EVENT_DIRECTION_CHANGE, dir );
+#endif
     }
 }
+#endif /* WIND_VANE_DEBOUNCE */
 
-void processRainBucket( void )
+#if WIND_VANE_VECTOR_AVG
+/**
+ * @brief   Adds a direction to the averaging windows
+ * @param   wm - The station
+ * @param   dir - The direction, WIND_VANE_DIRECTIONS_COUNT counts towards
+ *          the window length but not the average
+ * @retval  None
+ */
+static void _vectorAddWindVane( weatherMeter_t *wm, windVaneDir_t dir )
 {
-    // Grab the current count
-    _rainBucketCount = hrainBucketCounter->Instance->CNT;
-    // Clear it out
-    hrainBucketCounter->Instance->CNT = 0;
+    windVaneVectorBlock_t *block = &wm->vector.blocks[wm->vector.head];
+    windVaneVectorBlock_t *old;
+    int32_t east;
+    int32_t north;
+
+    // Odd while the sums are changing, so readers can tell
+    wm->vector.updates++;
+    WEATHER_METER_BARRIER();
+
+    if( dir < WIND_VANE_DIRECTIONS_COUNT )
+    {
+        east = WIND_VANE_SIN_Q15[dir];
+        north = WIND_VANE_SIN_Q15[( dir + 4 ) % WIND_VANE_DIRECTIONS_COUNT];
+        block->east += east;
+        block->north += north;
+        block->count++;
+        for( int i=0; i<2; i++ )
+        {
+            wm->vector.windows[i].east += east;
+            wm->vector.windows[i].north += north;
+            wm->vector.windows[i].count++;
+        }
+    }
+
+    if( ++wm->vector.buffers >= WIND_VANE_VECTOR_BLOCK )
+    {   // The block is full, move on to the next one.  It is the oldest
+        // block of the long window, and the short window loses the block
+        // WIND_VANE_VECTOR_SHORT_BLOCKS back
+        wm->vector.buffers = 0;
+        wm->vector.head = ( wm->vector.head + 1 ) % WIND_VANE_VECTOR_LONG_BLOCKS;
+
+        old = &wm->vector.blocks[( wm->vector.head + WIND_VANE_VECTOR_LONG_BLOCKS -
+                                WIND_VANE_VECTOR_SHORT_BLOCKS ) % WIND_VANE_VECTOR_LONG_BLOCKS];
+        wm->vector.windows[WIND_VANE_WINDOW_SHORT].east -= old->east;
+        wm->vector.windows[WIND_VANE_WINDOW_SHORT].north -= old->north;
+        wm->vector.windows[WIND_VANE_WINDOW_SHORT].count -= old->count;
+
+        old = &wm->vector.blocks[wm->vector.head];
+        wm->vector.windows[WIND_VANE_WINDOW_LONG].east -= old->east;
+        wm->vector.windows[WIND_VANE_WINDOW_LONG].north -= old->north;
+        wm->vector.windows[WIND_VANE_WINDOW_LONG].count -= old->count;
+        old->east = 0;
+        old->north = 0;
+        old->count = 0;
+    }
+
+    WEATHER_METER_BARRIER();
+    wm->vector.updates++;
 }
 
-double getRainfall_inperhr( void )
+#endif /* WIND_VANE_VECTOR_AVG */
+
+#if WIND_VANE_VECTOR_AVG || WEATHER_ROLLUP
+/**
+ * @brief   Integer four quadrant arctangent by CORDIC
+ * @param   east - The east component of the vector
+ * @param   north - The north component of the vector
+ * @retval  The bearing of the vector in thousandths of a degree
+ *          clockwise from N, -180000 to 180000
+ */
+static int32_t _atan2mdeg( int32_t east, int32_t north )
 {
-    return( _rainBucketCount * rainBucketConversion_inPerHr * 60 );
-}
+    // atan( 2^-i ) in thousandths of a degree
+    static const int32_t ATAN_MDEG[] = { 45000, 26565, 14036, 7125, 3576, 1790,
+                                         895, 448, 224, 112, 56, 28, 14, 7, 3, 2 };
+    int32_t x = north;
+    int32_t y = east;
+    int32_t angle = 0;
+    int32_t t;
+
+    // Leave headroom for the CORDIC gain
+    while( ( x > ( 1L << 28 ) ) || ( x < -( 1L << 28 ) ) ||
+           ( y > ( 1L << 28 ) ) || ( y < -( 1L << 28 ) ) )
+    {
+        x /= 2;
+        y /= 2;
+    }
+
+    // Rotate into the right half plane first
+    if( x < 0 )
+    {
+        t = x;
+        if( y >= 0 )
+        {
+            x = y;
+            y = -t;
+            angle = 90000;
+        }
+        else
+        {
+            x = -y;
+            y = t;
+            angle = -90000;
+        }
+    }
+
+    // Then rotate the vector onto the x axis, summing the angles
+    for( uint32_t i=0; i<sizeof( ATAN_MDEG ) / sizeof( ATAN_MDEG[0] ); i++ )
+    {
+        t = x;
+        if( y > 0 )
+        {
+            x += y >> i;
+            y -= t >> i;
+            angle += ATAN_MDEG[i];
+        }
+        else
+        {
+            x -= y >> i;
+            y += t >> i;
+            angle -= ATAN_MDEG[i];
+        }
+    }
+    return angle;
+}
+
+/**
+ * @brief   Integer square root
+ * @param   n - The number to take the root of
+ * @retval  The root, rounded down
+ */
+static uint32_t _isqrt64( uint64_t n )
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while( bit > n )
+    {
+        bit >>= 2;
+    }
+    while( bit != 0 )
+    {
+        if( n >= root + bit )
+        {
+            n -= root + bit;
+            root = ( root >> 1 ) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/**
+ * @brief   Turns sums of unit vectors into a mean direction
+ * @param   east - The sum of the east components
+ * @param   north - The sum of the north components
+ * @param   unit - The length of count unit vectors
+ * @param   direction - A pointer to store the mean direction, in tenths
+ *          of a degree clockwise from N
+ * @param   steadiness - A pointer to store the length of the mean vector
+ *          in thousandths.  May be NULL
+ * @retval  None
+ */
+static void _vectorMean( int32_t east, int32_t north, uint64_t unit,
+                         uint16_t *direction, uint16_t *steadiness )
+{
+    int32_t angle = _atan2mdeg( east, north );
+    uint64_t length;
+
+    if( angle < 0 )
+    {
+        angle += 360000;
+    }
+    *direction = (uint16_t)( ( ( angle + 50 ) / 100 ) % 3600 );
+
+    if( steadiness != NULL )
+    {
+        length = _isqrt64( (uint64_t)( (int64_t)east * east ) +
+                           (uint64_t)( (int64_t)north * north ) );
+        length = ( length * 1000 + unit / 2 ) / unit;
+        *steadiness = (uint16_t)( ( length > 1000 ) ? 1000 : length );
+    }
+}
+#endif /* WIND_VANE_VECTOR_AVG || WEATHER_ROLLUP */
+
+#if WIND_VANE_AUTOCAL
+void wmResetWindVaneAutoCal( weatherMeter_t *wm )
+{
+    const uint32_t *values = wm->windVaneValues;
+
+    // The values may be one of our own published tables, leave those be
+    for( int i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
+    {
+        wm->autoCal.seed[i] = values[i];
+        wm->autoCal.centers[i] = values[i] << WIND_VANE_AUTOCAL_FRAC_BITS;
+    }
+    memset( wm->autoCal.hist, 0, sizeof( wm->autoCal.hist ) );
+    wm->autoCal.decayBin = 0;
+    wm->autoCal.count = 0;
+#if WIND_VANE_USE_LUT
+    // Nothing to rebuild
+    wm->autoCal.lutCode = WIND_VANE_LUT_SIZE;
+#endif
+}
+
+/**
+ * @brief   Runs one step of the self calibration
+ * @param   wm - The station
+ * @param   average - The average of the buffer just processed
+ * @retval  None
+ */
+static void _autoCalWindVane( weatherMeter_t *wm, uint32_t average )
+{
+    uint32_t bin = average >> WIND_VANE_AUTOCAL_BIN_SHIFT;
+    uint32_t nearest = WIND_VANE_DIRECTIONS_COUNT;
+    uint32_t nearestDist = WIND_VANE_AUTOCAL_CAPTURE + 1;
+    uint32_t value;
+    uint32_t dist;
+    int32_t center;
+
+    if( bin >= WIND_VANE_AUTOCAL_BINS )
+    {   // Not a valid ADC code
+        return;
+    }
+
+    // Age one bin per buffer so the histogram follows recent readings,
+    // then count this one
+    wm->autoCal.hist[wm->autoCal.decayBin] >>= 1;
+    wm->autoCal.decayBin = ( wm->autoCal.decayBin + 1 ) % WIND_VANE_AUTOCAL_BINS;
+    if( wm->autoCal.hist[bin] < UINT16_MAX )
+    {
+        wm->autoCal.hist[bin]++;
+    }
+
+    // Only a position the vane keeps coming back to is allowed to pull a
+    // value, pull the nearest one within capture range
+    if( wm->autoCal.hist[bin] >= WIND_VANE_AUTOCAL_MIN_HITS )
+    {
+        for( uint32_t i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
+        {
+            value = wm->autoCal.centers[i] >> WIND_VANE_AUTOCAL_FRAC_BITS;
+            dist = ( average > value ) ? ( average - value ) : ( value - average );
+            if( dist < nearestDist )
+            {
+                nearest = i;
+                nearestDist = dist;
+            }
+        }
+    }
+
+    if( nearest < WIND_VANE_DIRECTIONS_COUNT )
+    {
+        center = (int32_t)wm->autoCal.centers[nearest];
+        center += ( (int32_t)( average << WIND_VANE_AUTOCAL_FRAC_BITS ) - center ) >>
+                  WIND_VANE_AUTOCAL_RATE_SHIFT;
+
+        // Never wander further than allowed from the starting table
+        if( center > (int32_t)( ( wm->autoCal.seed[nearest] + WIND_VANE_AUTOCAL_MAX_DRIFT ) << WIND_VANE_AUTOCAL_FRAC_BITS ) )
+        {
+            center = (int32_t)( ( wm->autoCal.seed[nearest] + WIND_VANE_AUTOCAL_MAX_DRIFT ) << WIND_VANE_AUTOCAL_FRAC_BITS );
+        }
+        else if( ( wm->autoCal.seed[nearest] > WIND_VANE_AUTOCAL_MAX_DRIFT ) &&
+                 ( center < (int32_t)( ( wm->autoCal.seed[nearest] - WIND_VANE_AUTOCAL_MAX_DRIFT ) << WIND_VANE_AUTOCAL_FRAC_BITS ) ) )
+        {
+            center = (int32_t)( ( wm->autoCal.seed[nearest] - WIND_VANE_AUTOCAL_MAX_DRIFT ) << WIND_VANE_AUTOCAL_FRAC_BITS );
+        }
+        wm->autoCal.centers[nearest] = (uint32_t)center;
+    }
+
+    // Publish the adjusted values into the table not in use and swap it in
+    // with a single pointer write
+    if( ++wm->autoCal.count >= WIND_VANE_AUTOCAL_PUBLISH )
+    {
+        uint32_t *table = wm->autoCal.tables[wm->autoCal.next];
+
+        wm->autoCal.count = 0;
+        for( uint32_t i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
+        {
+            table[i] = ( wm->autoCal.centers[i] + ( 1UL << ( WIND_VANE_AUTOCAL_FRAC_BITS - 1 ) ) ) >>
+                       WIND_VANE_AUTOCAL_FRAC_BITS;
+        }
+        wm->windVaneValues = table;
+        wm->autoCal.next ^= 1;
+#if WIND_VANE_USE_LUT
+        // Start rebuilding the lookup table for the new values
+        wm->autoCal.lutCode = 0;
+#endif
+    }
+
+#if WIND_VANE_USE_LUT
+    // Rebuild a slice of the lookup table per buffer.  Until it is done,
+    // codes close to a band edge that moved may read as an error
+    if( wm->autoCal.lutCode < WIND_VANE_LUT_SIZE )
+    {
+        uint32_t count = WIND_VANE_AUTOCAL_LUT_SLICE / 2;
+
+        if( count > WIND_VANE_LUT_SIZE - wm->autoCal.lutCode )
+        {
+            count = WIND_VANE_LUT_SIZE - wm->autoCal.lutCode;
+        }
+        _buildWindVaneLutSlice( wm, wm->autoCal.lutCode, count );
+        wm->autoCal.lutCode += count;
+    }
+#endif
+}
+#endif /* WIND_VANE_AUTOCAL */
+
+#if WIND_VANE_ESTIMATOR == WIND_VANE_ESTIMATOR_MEAN
+/**
+ * @brief   Sums a block of the ADC buffer
+ * @param   buf - The first sample of the block
+ * @param   len - The number of samples in the block
+ * @retval  The sum of the block
+ */
+static uint32_t _sumBlock( const windVaneSample_t *buf, uint32_t len )
+{
+    uint32_t sum = 0;
+    uint32_t i = 0;
+
+#if WIND_VANE_ADC_HALFWORD
+    uint32_t pair;
+
+#if defined( __ARM_FEATURE_DSP ) && ( __ARM_FEATURE_DSP == 1 )
+    // __SMLAD multiplies both halfwords by 1 and adds them to the sum, so
+    // two samples go in per instruction
+    for( ; i + 2 <= len; i += 2 )
+    {
+        memcpy( &pair, &buf[i], sizeof( pair ) );
+        sum = __SMLAD( pair, 0x00010001, sum );
+    }
+#else
+    // No DSP extension, add two samples at a time as the 16 bit lanes of
+    // a word instead.  A lane holds 16 12-bit samples before it carries
+    // into its neighbour, so fold the lanes into the sum every 16 words
+    while( i + 2 <= len )
+    {
+        uint32_t lanes = 0;
+
+        for( uint32_t j=0; ( j < 16 ) && ( i + 2 <= len ); j++, i += 2 )
+        {
+            memcpy( &pair, &buf[i], sizeof( pair ) );
+            lanes += pair;
+        }
+        sum += ( lanes & 0xFFFF ) + ( lanes >> 16 );
+    }
+#endif /* __ARM_FEATURE_DSP */
+#endif /* WIND_VANE_ADC_HALFWORD */
+
+    // Whatever is left over one sample at a time
+    for( ; i<len; i++ )
+    {
+        sum += buf[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief   Averages a block of the ADC buffer
+ * @param   buf - The first sample of the block
+ * @param   len - The number of samples in the block
+ * @retval  The average of the block
+ */
+static uint32_t _averageBlock( const windVaneSample_t *buf, uint32_t len )
+{
+    return( _sumBlock( buf, len ) / len );
+}
+#endif /* WIND_VANE_ESTIMATOR */
+
+#if WIND_VANE_ESTIMATOR != WIND_VANE_ESTIMATOR_MEAN
+/**
+ * @brief   Sums the k smallest samples of a coarse bin
+ * @param   row - The second pass histogram of the bin
+ * @param   bin - The coarse bin
+ * @param   k - The number of samples
+ * @retval  The sum
+ */
+static uint32_t _sumSmallest( const uint16_t *row, uint32_t bin, uint32_t k )
+{
+    uint32_t sum = 0;
+    uint32_t take;
+
+    for( uint32_t i=0; ( i < WIND_VANE_FINE_BINS ) && ( k != 0 ); i++ )
+    {
+        take = ( row[i] < k ) ? row[i] : k;
+        sum += take * ( ( bin << WIND_VANE_FINE_BITS ) | i );
+        k -= take;
+    }
+    return sum;
+}
+
+/**
+ * @brief   Finds the coarse bin holding a rank
+ * @param   h - The histograms
+ * @param   rank - The rank, 0 being the smallest sample
+ * @param   below - A pointer to store the number of samples in lower bins
+ * @param   sumBelow - A pointer to store the sum of the samples in lower
+ *          bins
+ * @retval  The bin
+ */
+static uint32_t _findRank( const windVaneRank_t *h, uint32_t rank, uint32_t *below, uint32_t *sumBelow )
+{
+    uint32_t bin = 0;
+
+    *below = 0;
+    *sumBelow = 0;
+    while( *below + h->coarseCount[bin] <= rank )
+    {
+        *below += h->coarseCount[bin];
+        *sumBelow += h->coarseSum[bin];
+        bin++;
+    }
+    return bin;
+}
+
+/**
+ * @brief   Reduces a block to the mean of the samples ranked lo to hi,
+ *          with a histogram of the coarse bins then a histogram of the
+ *          codes in the bins holding lo and hi
+ * @param   h - The histograms to use
+ * @param   buf - The first sample of the block
+ * @param   len - The number of samples in the block
+ * @retval  The median or the interquartile mean of the block
+ */
+static uint32_t _rankBlock( windVaneRank_t *h, const windVaneSample_t *buf, uint32_t len )
+{
+    const uint32_t mask = ( 1UL << WIND_VANE_ADC_BITS ) - 1;
+#if WIND_VANE_ESTIMATOR == WIND_VANE_ESTIMATOR_MEDIAN
+    const uint32_t lo = ( len - 1 ) / 2;
+    const uint32_t hi = len / 2;
+#else
+    const uint32_t lo = len / 4;
+    const uint32_t hi = len - 1 - ( len / 4 );
+#endif
+    uint32_t loBin, hiBin, loBelow, hiBelow, loSum, hiSum;
+    uint32_t code;
+    uint32_t sel;
+    uint32_t total;
+
+    memset( h, 0, sizeof( *h ) );
+
+    // Pass 1, count and sum the samples per coarse bin
+    for( uint32_t i=0; i<len; i++ )
+    {
+        code = buf[i] & mask;
+        h->coarseCount[code >> WIND_VANE_FINE_BITS]++;
+        h->coarseSum[code >> WIND_VANE_FINE_BITS] += code;
+    }
+
+    loBin = _findRank( h, lo, &loBelow, &loSum );
+    hiBin = _findRank( h, hi, &hiBelow, &hiSum );
+
+    // Pass 2, resolve the codes within the two bins of interest.  The row
+    // is picked arithmetically so there's no branch per sample
+    for( uint32_t i=0; i<len; i++ )
+    {
+        code = buf[i] & mask;
+        sel = (uint32_t)( ( code >> WIND_VANE_FINE_BITS ) == loBin ) |
+              ( (uint32_t)( ( code >> WIND_VANE_FINE_BITS ) == hiBin ) << 1 );
+        h->fineCount[sel][code & ( WIND_VANE_FINE_BINS - 1 )]++;
+    }
+
+    // Sum of ranks lo..hi is the sum of the hi + 1 smallest samples less
+    // the sum of the lo smallest
+    total = ( hiSum + _sumSmallest( h->fineCount[( loBin == hiBin ) ? 3 : 2], hiBin, hi + 1 - hiBelow ) ) -
+            ( loSum + _sumSmallest( h->fineCount[( loBin == hiBin ) ? 3 : 1], loBin, lo - loBelow ) );
+
+    return( ( total + ( ( hi - lo + 1 ) / 2 ) ) / ( hi - lo + 1 ) );
+}
+#endif /* WIND_VANE_ESTIMATOR */
+
+#if WIND_VANE_VOTE
+/**
+ * @brief   Classifies every sample of a block and tallies the votes
+ * @param   wm - The station
+ * @param   buf - The first sample of the block
+ * @param   len - The number of samples in the block
+ * @retval  The winning direction in the low byte, its share in percent in
+ *          the next, 0 when no direction won
+ */
+static uint32_t _voteBlock( weatherMeter_t *wm, const windVaneSample_t *buf, uint32_t len )
+{
+    uint32_t votes[WIND_VANE_DIRECTIONS_COUNT + 1] = { 0 };
+    uint32_t winner = WIND_VANE_DIRECTIONS_COUNT;
+
+    for( uint32_t i=0; i<len; i++ )
+    {
+        votes[_lookupWindVane( wm, buf[i] )]++;
+    }
+
+    // Errors can't win, they still count towards the share
+    for( uint32_t i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
+    {
+        if( ( votes[i] != 0 ) &&
+            ( ( winner == WIND_VANE_DIRECTIONS_COUNT ) || ( votes[i] > votes[winner] ) ) )
+        {
+            winner = i;
+        }
+    }
+    if( winner == WIND_VANE_DIRECTIONS_COUNT )
+    {   // Not a share of any direction
+        return winner;
+    }
+    return( winner | ( ( ( votes[winner] * 100 ) / len ) << 8 ) );
+}
+#endif /* WIND_VANE_VOTE */
+
+/**
+ * @brief   Reduces a block of the ADC buffer to a new reading
+ * @param   wm - The station
+ * @param   buf - The first sample of the block
+ * @param   len - The number of samples in the block
+ * @retval  None
+ */
+static void _processBlock( weatherMeter_t *wm, const windVaneSample_t *buf, uint32_t len )
+{
+    // Average into a local so wm->average is only ever written once and a
+    // reader never sees a partial sum
+#if WIND_VANE_ESTIMATOR == WIND_VANE_ESTIMATOR_MEAN
+    uint32_t average = _averageBlock( buf, len );
+#else
+    uint32_t average = _rankBlock( &wm->rank, buf, len );
+#endif
+    windVaneDir_t dir;
+
+    WEATHER_SNAPSHOT_BEGIN( wm->snapshot.vaneSeq );
+    wm->average = average;
+#if WEATHER_METER_SNAPSHOT
+    wm->snapshot.vaneTime = _nowMs( wm );
+#endif
+#if WIND_VANE_AUTOCAL
+    // The tables it swaps in classify the reading
+    _autoCalWindVane( wm, average );
+#endif
+    WEATHER_SNAPSHOT_END( wm->snapshot.vaneSeq );
+#if WEATHER_METER_EVENTS
+    _pushEvent( wm, WEATHER_EVENT_QUEUE_VANE, WEATHER_EVENT_VANE_READING, average );
+#endif
+
+    // The direction of this block, for the stages below
+#if WIND_VANE_VOTE
+    uint32_t vote = _voteBlock( wm, buf, len );
+
+    wm->vote = vote;
+    dir = (windVaneDir_t)( vote & 0xFF );
+#else
+    dir = _classifyWindVane( wm, average );
+#endif
+#if WEATHER_METER_HEALTH
+    if( dir == WIND_VANE_DIRECTIONS_COUNT )
+    {   // Once per buffer, however often the direction is read
+        wm->health.counts.vaneOutOfBand++;
+    }
+#endif
+
+#if WIND_VANE_DEBOUNCE
+    _debounceWindVane( wm, dir );
+#elif WEATHER_METER_EVENTS
+    // Without debouncing every change of a valid reading is an event
+    if( ( dir < WIND_VANE_DIRECTIONS_COUNT ) && ( dir != wm->lastDir ) )
+    {
+        wm->lastDir = (uint8_t)dir;
+        _pushEvent( wm, WEATHER_EVENT_QUEUE_VANE, WEATHER_EVENT_DIRECTION_CHANGE, dir );
+    }
+#endif
+#if WIND_VANE_VECTOR_AVG
+    _vectorAddWindVane( wm, dir );
+#endif
+    (void)dir;
+}
+
+void wmProcessWindVane( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+
+#if WEATHER_METER_HEALTH
+    _healthWindVane( wm, 0 );
+#endif
+    // Average the buffer
+    _processBlock( wm, wm->adcBuf, WIND_VANE_ADC_BUF_SIZE );
+    WEATHER_PROFILE_END( WEATHER_PROFILE_PROCESS_WIND_VANE );
+}
+
+#if WIND_VANE_DOUBLE_BUFFER
+void wmProcessWindVaneFirstHalf( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+
+#if WEATHER_METER_HEALTH
+    _healthWindVane( wm, 1 );
+#endif
+    // The DMA is now writing the second half, the first half is stable
+    _processBlock( wm, &wm->adcBuf[0], WIND_VANE_ADC_BUF_SIZE / 2 );
+    WEATHER_PROFILE_END( WEATHER_PROFILE_PROCESS_WIND_VANE_HALF );
+}
+
+void wmProcessWindVaneSecondHalf( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+
+#if WEATHER_METER_HEALTH
+    _healthWindVane( wm, 2 );
+#endif
+    // The DMA has wrapped around to the first half, the second is stable
+    _processBlock( wm, &wm->adcBuf[WIND_VANE_ADC_BUF_SIZE / 2],
+                   WIND_VANE_ADC_BUF_SIZE / 2 );
+    WEATHER_PROFILE_END( WEATHER_PROFILE_PROCESS_WIND_VANE_HALF );
+}
+
+#if WIND_VANE_HAL_CALLBACKS
+// The HAL has one callback for all ADCs, these serve the default station
+void HAL_ADC_ConvHalfCpltCallback( ADC_HandleTypeDef* hadc )
+{
+    if( hadc == _weatherMeter.windVaneAdc )
+    {
+        wmProcessWindVaneFirstHalf( &_weatherMeter );
+    }
+}
+
+void HAL_ADC_ConvCpltCallback( ADC_HandleTypeDef* hadc )
+{
+    if( hadc == _weatherMeter.windVaneAdc )
+    {
+        wmProcessWindVaneSecondHalf( &_weatherMeter );
+    }
+}
+#endif /* WIND_VANE_HAL_CALLBACKS */
+#endif /* WIND_VANE_DOUBLE_BUFFER */
+
+int8_t wmSetWindVaneTables( weatherMeter_t *wm, const uint32_t *values, const uint8_t *lut )
+{
+    if( values == NULL )
+    {   // There has to be a values table
+        return 1;
+    }
+
+#if WIND_VANE_USE_LUT
+    if( lut != NULL )
+    {   // Use the table given
+        wm->windVaneValues = values;
+        wm->windVaneLut = lut;
+    }
+    else
+    {
+#if WIND_VANE_EXTERNAL_TABLES
+        // No table given and nowhere to build one
+        return 1;
+#else
+        // Build one from the values
+        wm->windVaneValues = values;
+        wmBuildWindVaneLut( wm );
+#endif
+    }
+#else
+    // Not classifying with a lookup table
+    (void)lut;
+    wm->windVaneValues = values;
+#endif /* WIND_VANE_USE_LUT */
+
+#if WIND_VANE_AUTOCAL
+    wmResetWindVaneAutoCal( wm );
+#endif
+    return 0;
+}
+
+const uint32_t* wmGetWindVaneValues( weatherMeter_t *wm )
+{
+    return wm->windVaneValues;
+}
+
+windVaneDir_t wmGetWindVaneDirection( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+    windVaneDir_t dir = _classifyWindVane( wm, wm->average );
+
+    WEATHER_PROFILE_END( WEATHER_PROFILE_GET_WIND_VANE_DIRECTION );
+    return dir;
+}
+
+#if WIND_VANE_DEBOUNCE
+windVaneDir_t wmGetWindVaneDirectionDebounced( weatherMeter_t *wm )
+{
+    return( (windVaneDir_t)wm->debounce.committed );
+}
+
+uint32_t wmGetWindVaneDirChangeCount( weatherMeter_t *wm )
+{
+    return wm->debounce.changes;
+}
+
+uint8_t wmGetWindVaneDirChanged( weatherMeter_t *wm )
+{
+    uint32_t changes = wm->debounce.changes;
+
+    if( changes != wm->debounce.seen )
+    {
+        wm->debounce.seen = changes;
+        return 1;
+    }
+    return 0;
+}
+#endif /* WIND_VANE_DEBOUNCE */
+
+#if WIND_VANE_VOTE
+windVaneDir_t wmGetWindVaneVoteDirection( weatherMeter_t *wm, uint8_t *share )
+{
+    uint32_t vote = wm->vote;
+
+    if( share != NULL )
+    {
+        *share = (uint8_t)( vote >> 8 );
+    }
+    return( (windVaneDir_t)( vote & 0xFF ) );
+}
+#endif /* WIND_VANE_VOTE */
+
+#if WIND_VANE_VECTOR_AVG
+int8_t wmGetWindVaneMeanDirection( weatherMeter_t *wm, windVaneWindow_t window, uint16_t *direction,
+                                 uint16_t *steadiness )
+{
+    uint32_t updates;
+    windVaneVectorBlock_t sums;
+
+    if( ( direction == NULL ) || ( window > WIND_VANE_WINDOW_LONG ) )
+    {
+        return 1;
+    }
+
+    // Retry if processWindVane() ran while copying
+    do
+    {
+        updates = wm->vector.updates;
+        WEATHER_METER_BARRIER();
+        sums = wm->vector.windows[window];
+        WEATHER_METER_BARRIER();
+    } while( ( updates & 1 ) || ( updates != wm->vector.updates ) );
+
+    if( sums.count == 0 )
+    {   // Nothing to average
+        return 1;
+    }
+
+    _vectorMean( sums.east, sums.north, (uint64_t)sums.count * 32767, direction, steadiness );
+    return 0;
+}
+#endif /* WIND_VANE_VECTOR_AVG */
+
+void getWindVaneDirString( windVaneDir_t direction, uint8_t *string )
+{
+    WEATHER_PROFILE_BEGIN();
+
+    if( direction < WIND_VANE_DIRECTIONS_COUNT )
+    {   // There's a valid direction
+        strcpy( (char *)string, (char *)WIND_VANE_DIR_STRING[direction] );
+    }
+    else if( direction == WIND_VANE_DIRECTIONS_COUNT )
+    {   // There's an error
+        strcpy( (char *)string, "ERR" );
+    }
+    WEATHER_PROFILE_END( WEATHER_PROFILE_GET_WIND_VANE_DIR_STRING );
+}
+
+#if WEATHER_METER_FREE_RUNNING && !( WIND_SPEED_CAPTURE && RAIN_BUCKET_TIPS )
+/**
+ * @brief   Reads a free running counter
+ * @param   htim - The handle of the timer acting as the counter
+ * @param   last - The counter at the previous reading, updated
+ * @retval  The pulses counted since the previous reading
+ */
+static uint32_t _counterDelta( TIM_HandleTypeDef *htim, uint32_t *last )
+{
+    uint32_t cnt = htim->Instance->CNT;
+    // Unsigned subtraction masked to the counter width handles the wrap
+    uint32_t delta = ( cnt - *last ) & WEATHER_METER_COUNTER_MASK;
+
+    *last = cnt;
+    return delta;
+}
+#endif /* WEATHER_METER_FREE_RUNNING */
+
+#if !WIND_SPEED_CAPTURE || WIND_GUST || WEATHER_ROLLUP
+/**
+ * @brief   Converts anemometer pulses over a time to thousandths of a
+ *          speed unit, rounded
+ * @param   count - The pulses
+ * @param   ms - The milliseconds they took
+ * @param   factor - Thousandths of the unit per pulse per second,
+ *          WIND_SPEED_MILLI_MPH or WIND_SPEED_MILLI_UNIT
+ * @retval  The speed in thousandths of the unit, 0 if ms is 0
+ */
+static uint32_t _windSpeedMilli( uint32_t count, uint32_t ms, uint32_t factor )
+{
+    uint64_t milli;
+
+    if( ms == 0 )
+    {
+        return 0;
+    }
+    if( ms == 1000 )
+    {   // The usual once a second, no division
+        return( count * factor );
+    }
+    milli = ( (uint64_t)count * factor * 1000 + ms / 2 ) / ms;
+    return( ( milli > UINT32_MAX ) ? UINT32_MAX : (uint32_t)milli );
+}
+#endif
+
+/**
+ * @brief   Converts thousandths to hundredths, rounded
+ * @param   milli - The value in thousandths
+ * @retval  The value in hundredths
+ */
+static inline uint32_t _milliToCenti( uint32_t milli )
+{
+    return( ( milli / 5 + 1 ) / 2 );
+}
+
+/**
+ * @brief   Converts thousandths of WIND_SPEED_UNIT to what the _Unit
+ *          functions return, hundredths or the Beaufort force
+ * @param   milli - The speed in thousandths of the unit
+ * @retval  The speed to return
+ */
+static uint32_t _windSpeedUnitOut( uint32_t milli )
+{
+#if WIND_SPEED_UNIT == WIND_SPEED_UNIT_BEAUFORT
+    // The lowest speed of each force from 1 up, in thousandths of a m/s
+    static const uint32_t force[12] = { 300, 1600, 3400, 5500, 8000, 10800,
+                                        13900, 17200, 20800, 24500, 28500, 32700 };
+    uint32_t i = 0;
+
+    while( ( i < 12 ) && ( milli >= force[i] ) )
+    {
+        i++;
+    }
+    return i;
+#else
+    return _milliToCenti( milli );
+#endif
+}
+
+/**
+ * @brief   Converts rain bucket tips to thousandths of RAIN_UNIT
+ * @param   tips - The tips
+ * @retval  The rain in thousandths of the unit
+ */
+static inline uint32_t _rainMilliUnit( uint32_t tips )
+{
+    return( ( tips * RAIN_MILLI_UNIT_NUM ) / RAIN_MILLI_UNIT_DEN );
+}
+
+/**
+ * @brief   Converts rain bucket tips over a time to thousandths of a unit
+ *          per hour, rounded
+ * @param   tips - The tips
+ * @param   ms - The milliseconds they took
+ * @param   num - Thousandths of the unit per tip, over den
+ * @param   den - The denominator of num
+ * @retval  The rain rate in thousandths of the unit per hour
+ */
+static uint32_t _rainRateMilli( uint32_t tips, uint32_t ms, uint32_t num, uint32_t den )
+{
+    uint64_t milli;
+
+    if( ms == 0 )
+    {
+        return 0;
+    }
+    milli = ( (uint64_t)tips * num * 3600000UL + ( (uint64_t)den * ms ) / 2 ) / ( (uint64_t)den * ms );
+    return( ( milli > UINT32_MAX ) ? UINT32_MAX : (uint32_t)milli );
+}
+
+/**
+ * @brief   Converts thousandths to Q16.16, rounded.  65536 / 1000 is
+ *          8192 / 125, split so it stays in 32 bits
+ * @param   milli - The value in thousandths
+ * @retval  The value in 1/65536
+ */
+static inline uint32_t _milliToQ16( uint32_t milli )
+{
+    return( ( milli / 125 ) * 8192 + ( ( milli % 125 ) * 8192 + 62 ) / 125 );
+}
+
+#if WIND_SPEED_CAPTURE
+int8_t wmInitWindSpeedCapture( weatherMeter_t *wm, TIM_HandleTypeDef *htim, uint32_t channel )
+{
+    if( htim == NULL )
+    {   // There's something wrong with the timer handle
+        return 1;
+    }
+    else
+    {   // Grab a reference to the timer and its DMA and start capturing
+        wm->windSpeedTimer = htim;
+        wm->captureDma = htim->hdma[TIM_DMA_ID_CC1 + ( channel >> 2 )];
+        if( wm->captureDma == NULL )
+        {   // The channel has no DMA linked
+            return 1;
+        }
+        wm->captureRead = 0;
+        wm->captureValid = 0;
+        wm->captureHeld = 0;
+        wm->windSpeedPeriodQ8 = 0;
+        wm->windSpeedLastTime = wm->clock();
+        HAL_TIM_IC_Start_DMA( htim, channel, (uint32_t *)wm->captureBuf,
+                              WIND_SPEED_CAPTURE_BUF_SIZE );
+        return 0;
+    }
+}
+
+/**
+ * @brief   Counts the pulses of a lapped capture ring.  All of the ring
+ *          is newer than the last call, the rate over it is the speed and
+ *          that rate over the interval the count, as counting would give
+ * @param   wm - The station
+ * @param   write - The next entry the DMA writes
+ * @param   ms - The milliseconds since the last call
+ * @retval  The number of new pulses
+ */
+static uint32_t _processCaptureLap( weatherMeter_t *wm, uint32_t write, uint32_t ms )
+{
+    // Skip the oldest entry, the DMA may be overwriting it right now
+    const uint32_t periods = WIND_SPEED_CAPTURE_BUF_SIZE - 2;
+    uint16_t oldest = wm->captureBuf[( write + 1 ) % WIND_SPEED_CAPTURE_BUF_SIZE];
+    uint16_t newest = wm->captureBuf[( write + WIND_SPEED_CAPTURE_BUF_SIZE - 1 ) % WIND_SPEED_CAPTURE_BUF_SIZE];
+    uint32_t span = (uint16_t)( newest - oldest );
+
+    if( span == 0 )
+    {   // Not a real timing, treat it as the shortest
+        span = 1;
+    }
+    wm->windSpeedPeriodQ8 = ( ( span << 8 ) + periods / 2 ) / periods;
+    wm->captureLast = newest;
+    wm->captureValid = 1;
+    wm->captureHeld = 1;
+    wm->captureRead = write;
+#if WEATHER_METER_HEALTH
+    wm->health.counts.windSpeedWraps++;
+#endif
+
+    return( (uint32_t)( ( (uint64_t)ms * WIND_SPEED_CAPTURE_TICK_HZ * periods + 500ULL * span ) /
+                        ( 1000ULL * span ) ) );
+}
+
+/**
+ * @brief   Takes the new pulses out of the capture ring and updates the
+ *          period
+ * @param   wm - The station
+ * @param   ms - The milliseconds since the last call
+ * @retval  The number of new pulses
+ */
+static uint32_t _processCapture( weatherMeter_t *wm, uint32_t ms )
+{
+    // The DMA counts down the transfers left before it wraps
+    uint32_t write = ( WIND_SPEED_CAPTURE_BUF_SIZE -
+                       __HAL_DMA_GET_COUNTER( wm->captureDma ) ) % WIND_SPEED_CAPTURE_BUF_SIZE;
+    uint32_t pulses = ( write + WIND_SPEED_CAPTURE_BUF_SIZE - wm->captureRead ) % WIND_SPEED_CAPTURE_BUF_SIZE;
+    uint32_t now = _nowMs( wm );
+    uint32_t span = 0;
+    uint32_t periods = 0;
+    uint32_t elapsed;
+    uint16_t stamp;
+
+    // The position alone can't tell a lap from no pulses, but the last
+    // entry read is overwritten once the DMA has gone all the way round
+    if( wm->captureHeld &&
+        ( wm->captureBuf[( wm->captureRead + WIND_SPEED_CAPTURE_BUF_SIZE - 1 ) % WIND_SPEED_CAPTURE_BUF_SIZE] !=
+          wm->captureLast ) )
+    {
+        wm->captureLastTick = now;
+        return _processCaptureLap( wm, write, ms );
+    }
+
+    if( pulses == 0 )
+    {
+        elapsed = now - wm->captureLastTick;
+        if( elapsed >= WIND_SPEED_CAPTURE_STALL_MS )
+        {   // Calm, and the next pulse can't be timed against the last
+            wm->windSpeedPeriodQ8 = 0;
+            wm->captureValid = 0;
+        }
+        else if( wm->windSpeedPeriodQ8 != 0 )
+        {   // No pulse for longer than the last period means the wind has
+            // dropped at least that much already
+            elapsed = ( ( elapsed * WIND_SPEED_CAPTURE_TICK_HZ ) / 1000 ) << 8;
+            if( elapsed > wm->windSpeedPeriodQ8 )
+            {
+                wm->windSpeedPeriodQ8 = elapsed;
+            }
+        }
+        return 0;
+    }
+
+    // Time the new pulses against each other, 16 bit timer wraps are
+    // handled by the unsigned subtraction
+    while( wm->captureRead != write )
+    {
+        stamp = wm->captureBuf[wm->captureRead];
+        if( wm->captureValid )
+        {
+            span += (uint16_t)( stamp - wm->captureLast );
+            periods++;
+        }
+        wm->captureLast = stamp;
+        wm->captureValid = 1;
+        wm->captureHeld = 1;
+        wm->captureRead = ( wm->captureRead + 1 ) % WIND_SPEED_CAPTURE_BUF_SIZE;
+    }
+    wm->captureLastTick = now;
+
+    // One new pulse gives the latest period, several give their average,
+    // which is counting the pulses over the time they took.  The fraction
+    // of a tick is kept so the average gains resolution
+    if( periods != 0 )
+    {
+        wm->windSpeedPeriodQ8 = (uint32_t)( ( ( (uint64_t)span << 8 ) + periods / 2 ) / periods );
+    }
+    return pulses;
+}
+
+uint32_t wmGetWindSpeedPeriod( weatherMeter_t *wm )
+{
+    return( ( wm->windSpeedPeriodQ8 + 128 ) >> 8 );
+}
+#else
+int8_t wmInitWindSpeed( weatherMeter_t *wm, TIM_HandleTypeDef *htim )
+{
+    if( htim == NULL )
+    {   // There's something wrong with the timer handle
+        return 1;
+    }
+    else
+    {   // Grab a reference to the timer and start it
+        wm->windSpeedTimer = htim;
+#if WEATHER_METER_FREE_RUNNING
+        wm->windSpeedLastCnt = htim->Instance->CNT;
+#endif
+#if WEATHER_METER_HEALTH
+        // Only wraps from now on count
+        __HAL_TIM_CLEAR_FLAG( htim, TIM_FLAG_UPDATE );
+#endif
+        wm->windSpeedLastTime = wm->clock();
+        HAL_TIM_Base_Start( htim );
+        return 0;
+    }
+}
+#endif /* WIND_SPEED_CAPTURE */
+
+#if WIND_GUST
+/**
+ * @brief   Adds a speed sample to the gust tracking
+ * @param   wm - The station
+ * @param   count - The anemometer count of the sample
+ * @param   ms - The milliseconds it was counted over
+ * @retval  None
+ */
+static void _gustAddSample( weatherMeter_t *wm, uint32_t count, uint32_t ms )
+{
+    windGustEntry_t *entry;
+    uint32_t now = _nowMs( wm );
+    uint32_t gust;
+
+    if( count > UINT16_MAX )
+    {
+        count = UINT16_MAX;
+    }
+
+    // Odd while the state is changing, so readers can tell
+    wm->gust.updates++;
+    WEATHER_METER_BARRIER();
+
+    // Running sums of the last samples and the time they took
+    wm->gust.sum = wm->gust.sum - wm->gust.samples[wm->gust.sampleIdx] + count;
+    wm->gust.sumMs = wm->gust.sumMs - wm->gust.intervals[wm->gust.sampleIdx] + ms;
+    wm->gust.samples[wm->gust.sampleIdx] = (uint16_t)count;
+    wm->gust.intervals[wm->gust.sampleIdx] = ms;
+    wm->gust.sampleIdx = ( wm->gust.sampleIdx + 1 ) % WIND_GUST_SAMPLES;
+
+    // Scaled to WIND_GUST_SAMPLES seconds, whatever the call cadence
+    if( wm->gust.sumMs == WIND_GUST_SAMPLES * 1000 )
+    {
+        gust = wm->gust.sum;
+    }
+    else if( wm->gust.sumMs != 0 )
+    {
+        gust = (uint32_t)( ( (uint64_t)wm->gust.sum * ( WIND_GUST_SAMPLES * 1000 ) + wm->gust.sumMs / 2 ) / wm->gust.sumMs );
+    }
+    else
+    {
+        gust = 0;
+    }
+    gust = ( gust > UINT16_MAX ) ? UINT16_MAX : gust;
+    wm->gust.gust = gust;
+
+    // Gusts no bigger than the new one can never be the peak again,
+    // drop them from the back so the queue stays decreasing
+    while( ( wm->gust.len != 0 ) &&
+           ( wm->gust.queue[( wm->gust.head + wm->gust.len - 1 ) % WIND_GUST_QUEUE_SIZE].count <= gust ) )
+    {
+        wm->gust.len--;
+    }
+    // Drop gusts that left the window from the front, and the oldest if
+    // it's full
+    while( ( wm->gust.len != 0 ) &&
+           ( ( now - wm->gust.queue[wm->gust.head].timestamp >= WIND_GUST_PEAK_MS ) ||
+             ( wm->gust.len == WIND_GUST_QUEUE_SIZE ) ) )
+    {
+        wm->gust.head = ( wm->gust.head + 1 ) % WIND_GUST_QUEUE_SIZE;
+        wm->gust.len--;
+    }
+
+    entry = &wm->gust.queue[( wm->gust.head + wm->gust.len ) % WIND_GUST_QUEUE_SIZE];
+    entry->timestamp = now;
+    entry->count = (uint16_t)gust;
+    entry->direction = (uint8_t)_classifyWindVane( wm, wm->average );
+    wm->gust.len++;
+
+    WEATHER_METER_BARRIER();
+    wm->gust.updates++;
+}
+#endif /* WIND_GUST */
+
+#if WEATHER_ROLLUP
+/**
+ * @brief   Adds a sample of wind to the speed and direction rollups
+ * @param   wm - The station
+ * @param   count - The anemometer count of the sample
+ * @param   ms - The milliseconds it was counted over
+ * @retval  None
+ */
+static void _rollupAddWind( weatherMeter_t *wm, uint32_t count, uint32_t ms )
+{
+    windVaneDir_t dir = _classifyWindVane( wm, wm->average );
+    uint32_t speed[2];
+    uint32_t vector[3] = { 0, 0, 0 };
+
+    speed[0] = count;
+    speed[1] = ms;
+    _rollupPush( &wm->rollupSpeed, speed, ms );
+
+    if( dir < WIND_VANE_DIRECTIONS_COUNT )
+    {   // Q8 unit vectors keep the sums in range over the days level
+        vector[0] = (uint32_t)(int32_t)( ( WIND_VANE_SIN_Q15[dir] + 64 ) >> 7 );
+        vector[1] = (uint32_t)(int32_t)( ( WIND_VANE_SIN_Q15[( dir + 4 ) % WIND_VANE_DIRECTIONS_COUNT] + 64 ) >> 7 );
+        vector[2] = 1;
+    }
+    // An error adds nothing, the time still moves the buckets on
+    _rollupPush( &wm->rollupDir, vector, ms );
+}
+#endif /* WEATHER_ROLLUP */
+
+void wmProcessWindSpeed( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+    uint32_t ms;
+
+    WEATHER_SNAPSHOT_BEGIN( wm->snapshot.speedSeq );
+    // The time the count is taken over, rates don't rely on the cadence
+    ms = _elapsedMs( wm, &wm->windSpeedLastTime );
+#if WIND_SPEED_CAPTURE
+    // Pulses since the last call, the period is updated with them
+    wm->windSpeedCount = _processCapture( wm, ms );
+#elif WEATHER_METER_FREE_RUNNING
+    // Count since the last call, the timer keeps running
+    wm->windSpeedCount = _counterDelta( wm->windSpeedTimer, &wm->windSpeedLastCnt );
+#else
+    // Grab the current count from the timer
+    wm->windSpeedCount = wm->windSpeedTimer->Instance->CNT;
+    // Clear it out
+    wm->windSpeedTimer->Instance->CNT = 0;
+#endif
+    wm->windSpeedInterval = ms;
+#if WEATHER_METER_SNAPSHOT
+    wm->snapshot.speedTime = _nowMs( wm );
+#endif
+    WEATHER_SNAPSHOT_END( wm->snapshot.speedSeq );
+#if WEATHER_METER_HEALTH
+#if !WIND_SPEED_CAPTURE
+#if WEATHER_METER_FREE_RUNNING
+    _healthWrap( wm->windSpeedTimer, wm->windSpeedCount, wm->windSpeedLastCnt,
+                 &wm->health.counts.windSpeedWraps );
+#else
+    _healthWrap( wm->windSpeedTimer, wm->windSpeedCount, wm->windSpeedCount,
+                 &wm->health.counts.windSpeedWraps );
+#endif
+#endif
+    _healthCadence( ms, WEATHER_METER_HEALTH_WIND_SPEED_MS,
+                    &wm->health.counts.windSpeedLate, &wm->health.counts.windSpeedMissed );
+#endif
+#if WIND_GUST
+    _gustAddSample( wm, wm->windSpeedCount, ms );
+#endif
+#if WEATHER_ROLLUP
+    _rollupAddWind( wm, wm->windSpeedCount, ms );
+#endif
+#if WEATHER_METER_EVENTS
+    _pushEvent( wm, WEATHER_EVENT_QUEUE_SPEED, WEATHER_EVENT_WIND_SPEED, wm->windSpeedCount );
+#endif
+    WEATHER_PROFILE_END( WEATHER_PROFILE_PROCESS_WIND_SPEED );
+}
+
+uint32_t wmGetWindSpeedCount( weatherMeter_t *wm )
+{
+    return wm->windSpeedCount;
+}
+
+/**
+ * @brief   Converts the wind speed to thousandths of a unit
+ * @param   wm - The station
+ * @param   factor - Thousandths of the unit per pulse per second
+ * @retval  The wind speed in thousandths of the unit
+ */
+static uint32_t _windSpeedNowMilli( weatherMeter_t *wm, uint32_t factor )
+{
+#if WIND_SPEED_CAPTURE
+    uint32_t period = wm->windSpeedPeriodQ8;
+    uint64_t milli;
+
+    // The conversion is per pulse per second, one pulse per period
+    if( period == 0 )
+    {
+        return 0;
+    }
+    milli = ( ( (uint64_t)WIND_SPEED_CAPTURE_TICK_HZ * factor << 8 ) + period / 2 ) / period;
+    return( ( milli > UINT32_MAX ) ? UINT32_MAX : (uint32_t)milli );
+#else
+    return _windSpeedMilli( wm->windSpeedCount, wm->windSpeedInterval, factor );
+#endif
+}
+
+uint32_t wmGetWindSpeed_cMPH( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+    uint32_t speed = _milliToCenti( _windSpeedNowMilli( wm, WIND_SPEED_MILLI_MPH ) );
+
+    WEATHER_PROFILE_END( WEATHER_PROFILE_GET_WIND_SPEED );
+    return speed;
+}
+
+uint32_t wmGetWindSpeed_Q16( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+    uint32_t speed = _milliToQ16( _windSpeedNowMilli( wm, WIND_SPEED_MILLI_MPH ) );
+
+    WEATHER_PROFILE_END( WEATHER_PROFILE_GET_WIND_SPEED );
+    return speed;
+}
+
+uint32_t wmGetWindSpeed_Unit( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+    uint32_t speed = _windSpeedUnitOut( _windSpeedNowMilli( wm, WIND_SPEED_MILLI_UNIT ) );
+
+    WEATHER_PROFILE_END( WEATHER_PROFILE_GET_WIND_SPEED );
+    return speed;
+}
+
+#if WEATHER_METER_USE_DOUBLE
+double wmGetWindSpeed_MPH( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+    double speed = _windSpeedNowMilli( wm, WIND_SPEED_MILLI_MPH ) / 1000.0;
+
+    WEATHER_PROFILE_END( WEATHER_PROFILE_GET_WIND_SPEED );
+    return speed;
+}
+#endif
+
+#if WIND_GUST
+uint32_t wmGetWindGust_cMPH( weatherMeter_t *wm )
+{
+    return _milliToCenti( _windSpeedMilli( wm->gust.gust, WIND_GUST_SAMPLES * 1000, WIND_SPEED_MILLI_MPH ) );
+}
+
+int8_t wmGetWindGustPeak( weatherMeter_t *wm, windGust_t *gust )
+{
+    uint32_t updates;
+    windGustEntry_t peak;
+    uint32_t len;
+
+    if( gust == NULL )
+    {
+        return 1;
+    }
+
+    // Retry if processWindSpeed() ran while copying
+    do
+    {
+        updates = wm->gust.updates;
+        WEATHER_METER_BARRIER();
+        len = wm->gust.len;
+        peak = wm->gust.queue[wm->gust.head];
+        WEATHER_METER_BARRIER();
+    } while( ( updates & 1 ) || ( updates != wm->gust.updates ) );
+
+    if( len == 0 )
+    {   // No samples yet
+        return 1;
+    }
+    gust->count = peak.count;
+    gust->timestamp = peak.timestamp;
+    gust->direction = (windVaneDir_t)peak.direction;
+    return 0;
+}
+
+/**
+ * @brief   Returns the peak gust in thousandths of a unit
+ * @param   wm - The station
+ * @param   factor - Thousandths of the unit per pulse per second
+ * @retval  The peak gust, 0 if there are no samples yet
+ */
+static uint32_t _windGustPeakMilli( weatherMeter_t *wm, uint32_t factor )
+{
+    windGust_t gust;
+
+    if( wmGetWindGustPeak( wm, &gust ) != 0 )
+    {
+        return 0;
+    }
+    return _windSpeedMilli( gust.count, WIND_GUST_SAMPLES * 1000, factor );
+}
+
+uint32_t wmGetWindGustPeak_cMPH( weatherMeter_t *wm )
+{
+    return _milliToCenti( _windGustPeakMilli( wm, WIND_SPEED_MILLI_MPH ) );
+}
+
+uint32_t wmGetWindGust_Unit( weatherMeter_t *wm )
+{
+    return _windSpeedUnitOut( _windSpeedMilli( wm->gust.gust, WIND_GUST_SAMPLES * 1000, WIND_SPEED_MILLI_UNIT ) );
+}
+
+uint32_t wmGetWindGustPeak_Unit( weatherMeter_t *wm )
+{
+    return _windSpeedUnitOut( _windGustPeakMilli( wm, WIND_SPEED_MILLI_UNIT ) );
+}
+
+#if WEATHER_METER_USE_DOUBLE
+double wmGetWindGust_MPH( weatherMeter_t *wm )
+{
+    return( _windSpeedMilli( wm->gust.gust, WIND_GUST_SAMPLES * 1000, WIND_SPEED_MILLI_MPH ) / 1000.0 );
+}
+
+double wmGetWindGustPeak_MPH( weatherMeter_t *wm )
+{
+    return( _windGustPeakMilli( wm, WIND_SPEED_MILLI_MPH ) / 1000.0 );
+}
+#endif /* WEATHER_METER_USE_DOUBLE */
+#endif /* WIND_GUST */
+
+#if RAIN_BUCKET_TIPS
+int8_t wmInitRainBucketTips( weatherMeter_t *wm )
+{
+    wm->rainTips.seen = wm->rainTips.count;
+    wm->rainBucketLastTime = wm->clock();
+    return 0;
+}
+
+void wmRainBucketTip( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+    uint32_t now = _nowMs( wm );
+    uint32_t count = wm->rainTips.count;
+
+    // The bucket can't tip again this soon, it's the switch bouncing
+    if( ( count != 0 ) &&
+        ( now - wm->rainTips.times[( count - 1 ) & ( RAIN_BUCKET_TIPS_RING - 1 )] < RAIN_BUCKET_TIPS_DEBOUNCE_MS ) )
+    {
+        WEATHER_PROFILE_END( WEATHER_PROFILE_RAIN_BUCKET_TIP );
+        return;
+    }
+
+    WEATHER_SNAPSHOT_BEGIN( wm->snapshot.tipSeq );
+    wm->rainTips.times[count & ( RAIN_BUCKET_TIPS_RING - 1 )] = now;
+    // Publish the time only once it's written
+    WEATHER_METER_BARRIER();
+    wm->rainTips.count = count + 1;
+    WEATHER_SNAPSHOT_END( wm->snapshot.tipSeq );
+#if WEATHER_METER_EVENTS
+    _pushEvent( wm, WEATHER_EVENT_QUEUE_RAIN, WEATHER_EVENT_RAIN_TIP, 1 );
+#endif
+    WEATHER_PROFILE_END( WEATHER_PROFILE_RAIN_BUCKET_TIP );
+}
+
+uint32_t wmGetRainBucketTips( weatherMeter_t *wm )
+{
+    return wm->rainTips.count;
+}
+
+/**
+ * @brief   Returns the rain rate from the time between the last tips.
+ *          Once the wait for the next tip is longer than the time between
+ *          the last ones, the rate decays as one tip over the wait
+ * @param   wm - The station
+ * @param   num - Thousandths of the unit per tip, over den
+ * @param   den - The denominator of num
+ * @retval  The rain rate in thousandths of the unit per hour
+ */
+static uint32_t _rainTipRateMilli( weatherMeter_t *wm, uint32_t num, uint32_t den )
+{
+    uint32_t count;
+    uint32_t intervals;
+    uint32_t last;
+    uint32_t first;
+    uint32_t since;
+
+    // Retry if a tip came in while reading
+    do
+    {
+        count = wm->rainTips.count;
+        WEATHER_METER_BARRIER();
+        if( count < 2 )
+        {   // No interval yet
+            return 0;
+        }
+        intervals = ( count - 1 < RAIN_BUCKET_TIPS_AVERAGE ) ? ( count - 1 ) : RAIN_BUCKET_TIPS_AVERAGE;
+        last = wm->rainTips.times[( count - 1 ) & ( RAIN_BUCKET_TIPS_RING - 1 )];
+        first = wm->rainTips.times[( count - 1 - intervals ) & ( RAIN_BUCKET_TIPS_RING - 1 )];
+        WEATHER_METER_BARRIER();
+    } while( count != wm->rainTips.count );
+
+    since = _nowMs( wm ) - last;
+    if( since >= RAIN_BUCKET_TIPS_TIMEOUT_MS )
+    {   // It stopped raining
+        return 0;
+    }
+    if( (uint64_t)since * intervals > last - first )
+    {
+        return _rainRateMilli( 1, since, num, den );
+    }
+    return _rainRateMilli( intervals, last - first, num, den );
+}
+#else
+int8_t wmInitRainBucket( weatherMeter_t *wm, TIM_HandleTypeDef *htim )
+{
+    if( htim == NULL )
+    {   // There's something wrong with the timer handle
+        return 1;
+    }
+    else
+    {   // Grab a reference to the timer handle and start it
+        wm->rainBucketCounter = htim;
+#if WEATHER_METER_FREE_RUNNING
+        wm->rainBucketLastCnt = htim->Instance->CNT;
+#endif
+#if WEATHER_METER_HEALTH
+        // Only wraps from now on count
+        __HAL_TIM_CLEAR_FLAG( htim, TIM_FLAG_UPDATE );
+#endif
+        wm->rainBucketLastTime = wm->clock();
+        HAL_TIM_Base_Start( htim );
+        return 0;
+    }
+}
+#endif /* RAIN_BUCKET_TIPS */
+
+#if RAIN_TOTALS
+/**
+ * @brief   Closes the open minute, and quarter hour when it's complete
+ * @param   wm - The station
+ * @retval  None
+ */
+static void _rainTotalsNextMinute( weatherMeter_t *wm )
+{
+    wm->rainTotals.minuteIdx = ( wm->rainTotals.minuteIdx + 1 ) % 60;
+    wm->rainTotals.hourSum -= wm->rainTotals.minutes[wm->rainTotals.minuteIdx];
+    wm->rainTotals.minutes[wm->rainTotals.minuteIdx] = 0;
+
+    if( ++wm->rainTotals.quarterPhase == 15 )
+    {
+        wm->rainTotals.quarterPhase = 0;
+        wm->rainTotals.quarterIdx = ( wm->rainTotals.quarterIdx + 1 ) % 96;
+        wm->rainTotals.daySum -= wm->rainTotals.quarters[wm->rainTotals.quarterIdx];
+        wm->rainTotals.quarters[wm->rainTotals.quarterIdx] = 0;
+    }
+}
+
+/**
+ * @brief   Adds the tips of a processRainBucket() call to the totals
+ * @param   wm - The station
+ * @param   tips - The tips
+ * @param   ms - The milliseconds since the previous call
+ * @retval  None
+ */
+static void _rainTotalsAdd( weatherMeter_t *wm, uint32_t tips, uint32_t ms )
+{
+    uint32_t now = _nowMs( wm );
+    uint32_t minutes;
+    uint32_t add;
+    uint8_t endDay = 0;
+    uint32_t day = 0;
+    int8_t change = -1;
+
+    // Odd while the state is changing, so readers can tell
+    wm->rainTotals.updates++;
+    WEATHER_METER_BARRIER();
+
+    // Close the minutes that passed, the tips go in the open one
+    wm->rainTotals.pendingMs += ms;
+    minutes = wm->rainTotals.pendingMs / 60000UL;
+    wm->rainTotals.pendingMs %= 60000UL;
+    if( minutes >= 96 * 15 )
+    {   // Longer than the 24 hours ring, all of it is dry
+        memset( wm->rainTotals.minutes, 0, sizeof( wm->rainTotals.minutes ) );
+        memset( wm->rainTotals.quarters, 0, sizeof( wm->rainTotals.quarters ) );
+        wm->rainTotals.hourSum = 0;
+        wm->rainTotals.daySum = 0;
+    }
+    else
+    {
+        while( minutes-- != 0 )
+        {
+            _rainTotalsNextMinute( wm );
+        }
+    }
+
+    add = UINT16_MAX - wm->rainTotals.minutes[wm->rainTotals.minuteIdx];
+    add = ( tips < add ) ? tips : add;
+    wm->rainTotals.minutes[wm->rainTotals.minuteIdx] += (uint16_t)add;
+    wm->rainTotals.hourSum += add;
+    add = UINT16_MAX - wm->rainTotals.quarters[wm->rainTotals.quarterIdx];
+    add = ( tips < add ) ? tips : add;
+    wm->rainTotals.quarters[wm->rainTotals.quarterIdx] += (uint16_t)add;
+    wm->rainTotals.daySum += add;
+    wm->rainTotals.total += tips;
+
+#if RAIN_TOTALS_DAY_MS
+    wm->rainTotals.dayMs += ms;
+    if( wm->rainTotals.dayMs >= RAIN_TOTALS_DAY_MS )
+    {   // The tips so far are the day's, these go in the next one
+        wm->rainTotals.dayMs %= RAIN_TOTALS_DAY_MS;
+        day = wm->rainTotals.today;
+        wm->rainTotals.today = 0;
+        endDay = 1;
+    }
+#endif
+    wm->rainTotals.today += tips;
+
+    // Rain events start with a tip and end after a dry spell
+    if( tips != 0 )
+    {
+        if( !wm->rainTotals.raining )
+        {
+            wm->rainTotals.raining = 1;
+            wm->rainTotals.eventTips = 0;
+            wm->rainTotals.eventStart = now;
+            change = WEATHER_EVENT_RAIN_START;
+        }
+        wm->rainTotals.eventTips += tips;
+        wm->rainTotals.eventEnd = now;
+        wm->rainTotals.dryMs = 0;
+    }
+    else if( wm->rainTotals.raining )
+    {
+        wm->rainTotals.dryMs += ms;
+        if( wm->rainTotals.dryMs >= RAIN_EVENT_DRY_MINUTES * 60000UL )
+        {
+            wm->rainTotals.raining = 0;
+            change = WEATHER_EVENT_RAIN_STOP;
+        }
+    }
+
+    WEATHER_METER_BARRIER();
+    wm->rainTotals.updates++;
+
+    // Outside the update, so the hook can read the totals
+    if( endDay && ( wm->rainTotals.hook != NULL ) )
+    {
+        wm->rainTotals.hook( wm, day );
+    }
+
+#if WEATHER_METER_EVENTS
+    if( change >= 0 )
+    {
+        _pushEvent( wm, WEATHER_EVENT_QUEUE_RAIN_EVENTS, (weatherEventType_t)change, wm->rainTotals.eventTips );
+    }
+#else
+    (void)change;
+#endif
+}
+
+void wmSetRainDayHook( weatherMeter_t *wm, rainDayHook_t hook )
+{
+    wm->rainTotals.hook = hook;
+}
+
+void wmResetRainDay( weatherMeter_t *wm )
+{
+    uint32_t day;
+
+    wm->rainTotals.updates++;
+    WEATHER_METER_BARRIER();
+    day = wm->rainTotals.today;
+    wm->rainTotals.today = 0;
+#if RAIN_TOTALS_DAY_MS
+    wm->rainTotals.dayMs = 0;
+#endif
+    WEATHER_METER_BARRIER();
+    wm->rainTotals.updates++;
+
+    if( wm->rainTotals.hook != NULL )
+    {
+        wm->rainTotals.hook( wm, day );
+    }
+}
+
+int8_t wmGetRainTotals( weatherMeter_t *wm, rainTotals_t *totals )
+{
+    uint32_t updates;
+
+    if( totals == NULL )
+    {
+        return 1;
+    }
+
+    // Retry if processRainBucket() ran while copying
+    do
+    {
+        updates = wm->rainTotals.updates;
+        WEATHER_METER_BARRIER();
+        totals->total = wm->rainTotals.total;
+        totals->lastHour = wm->rainTotals.hourSum;
+        totals->last24h = wm->rainTotals.daySum;
+        totals->today = wm->rainTotals.today;
+        totals->eventTips = wm->rainTotals.eventTips;
+        totals->eventStart = wm->rainTotals.eventStart;
+        totals->eventEnd = wm->rainTotals.eventEnd;
+        totals->raining = wm->rainTotals.raining;
+        WEATHER_METER_BARRIER();
+    } while( ( updates & 1 ) || ( updates != wm->rainTotals.updates ) );
+
+    return 0;
+}
+#endif /* RAIN_TOTALS */
+
+void wmProcessRainBucket( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+
+    WEATHER_SNAPSHOT_BEGIN( wm->snapshot.rainSeq );
+#if RAIN_BUCKET_TIPS
+    // Tips the interrupt counted since the last call
+    uint32_t count = wm->rainTips.count;
+
+    wm->rainBucketCount = count - wm->rainTips.seen;
+    wm->rainTips.seen = count;
+#elif WEATHER_METER_FREE_RUNNING
+    // Count since the last call, the timer keeps running
+    wm->rainBucketCount = _counterDelta( wm->rainBucketCounter, &wm->rainBucketLastCnt );
+#else
+    // Grab the current count
+    wm->rainBucketCount = wm->rainBucketCounter->Instance->CNT;
+    // Clear it out
+    wm->rainBucketCounter->Instance->CNT = 0;
+#endif
+    wm->rainBucketInterval = _elapsedMs( wm, &wm->rainBucketLastTime );
+#if WEATHER_METER_SNAPSHOT
+    wm->snapshot.rainTime = _nowMs( wm );
+#endif
+    WEATHER_SNAPSHOT_END( wm->snapshot.rainSeq );
+#if WEATHER_METER_HEALTH
+#if !RAIN_BUCKET_TIPS
+#if WEATHER_METER_FREE_RUNNING
+    _healthWrap( wm->rainBucketCounter, wm->rainBucketCount, wm->rainBucketLastCnt,
+                 &wm->health.counts.rainBucketWraps );
+#else
+    _healthWrap( wm->rainBucketCounter, wm->rainBucketCount, wm->rainBucketCount,
+                 &wm->health.counts.rainBucketWraps );
+#endif
+#endif
+    _healthCadence( wm->rainBucketInterval, WEATHER_METER_HEALTH_RAIN_BUCKET_MS,
+                    &wm->health.counts.rainBucketLate, &wm->health.counts.rainBucketMissed );
+#endif
+#if WEATHER_ROLLUP
+    {
+        uint32_t tips = wm->rainBucketCount;
+
+        _rollupPush( &wm->rollupRain, &tips, wm->rainBucketInterval );
+    }
+#endif
+#if RAIN_TOTALS
+    _rainTotalsAdd( wm, wm->rainBucketCount, wm->rainBucketInterval );
+#endif
+#if WEATHER_METER_EVENTS && !RAIN_BUCKET_TIPS
+    if( wm->rainBucketCount != 0 )
+    {
+        _pushEvent( wm, WEATHER_EVENT_QUEUE_RAIN, WEATHER_EVENT_RAIN_TIP, wm->rainBucketCount );
+    }
+#endif
+    WEATHER_PROFILE_END( WEATHER_PROFILE_PROCESS_RAIN_BUCKET );
+}
+
+/**
+ * @brief   Returns the rain rate in thousandths of a unit per hour
+ * @param   wm - The station
+ * @param   num - Thousandths of the unit per tip, numerator
+ * @param   den - Thousandths of the unit per tip, denominator
+ * @retval  The rain rate
+ */
+static uint32_t _rainfallMilli( weatherMeter_t *wm, uint32_t num, uint32_t den )
+{
+#if RAIN_BUCKET_TIPS
+    return _rainTipRateMilli( wm, num, den );
+#else
+    return _rainRateMilli( wm->rainBucketCount, wm->rainBucketInterval, num, den );
+#endif
+}
+
+uint32_t wmGetRainfall_milliInPerHr( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+    uint32_t rate = _rainfallMilli( wm, RAIN_BUCKET_MILLI_INCH, 1 );
+
+    WEATHER_PROFILE_END( WEATHER_PROFILE_GET_RAINFALL );
+    return rate;
+}
+
+uint32_t wmGetRainfall_Unit( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+    uint32_t rate = _rainfallMilli( wm, RAIN_MILLI_UNIT_NUM, RAIN_MILLI_UNIT_DEN );
+
+    WEATHER_PROFILE_END( WEATHER_PROFILE_GET_RAINFALL );
+    return rate;
+}
+
+#if WEATHER_METER_USE_DOUBLE
+double wmGetRainfall_inperhr( weatherMeter_t *wm )
+{
+    WEATHER_PROFILE_BEGIN();
+    double rate = _rainfallMilli( wm, RAIN_BUCKET_MILLI_INCH, 1 ) / 1000.0;
+
+    WEATHER_PROFILE_END( WEATHER_PROFILE_GET_RAINFALL );
+    return rate;
+}
+#endif
+
+#if WEATHER_ROLLUP
+int8_t wmGetWindSpeedRollup( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets,
+                           uint32_t *count, uint32_t *ms )
+{
+    uint32_t totals[2];
+
+    if( count == NULL )
+    {
+        return 1;
+    }
+    if( _rollupRead( &wm->rollupSpeed, level, buckets, totals ) == 0 )
+    {
+        return 1;
+    }
+    *count = totals[0];
+    if( ms != NULL )
+    {
+        *ms = totals[1];
+    }
+    return 0;
+}
+
+/**
+ * @brief   Returns the rollup mean wind speed in thousandths of a unit
+ * @param   wm - The station
+ * @param   level - The bucket size
+ * @param   buckets - The buckets to cover
+ * @param   factor - Thousandths of the unit per pulse per second
+ * @retval  The mean wind speed, 0 if there is no data
+ */
+static uint32_t _windSpeedMeanMilli( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets,
+                                     uint32_t factor )
+{
+    uint32_t count;
+    uint32_t ms;
+
+    if( wmGetWindSpeedRollup( wm, level, buckets, &count, &ms ) != 0 )
+    {
+        return 0;
+    }
+    return _windSpeedMilli( count, ms, factor );
+}
+
+uint32_t wmGetWindSpeedMean_cMPH( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets )
+{
+    return _milliToCenti( _windSpeedMeanMilli( wm, level, buckets, WIND_SPEED_MILLI_MPH ) );
+}
+
+uint32_t wmGetWindSpeedMean_Unit( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets )
+{
+    return _windSpeedUnitOut( _windSpeedMeanMilli( wm, level, buckets, WIND_SPEED_MILLI_UNIT ) );
+}
+
+int8_t wmGetWindDirRollup( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets,
+                         uint16_t *direction, uint16_t *steadiness )
+{
+    uint32_t totals[3];
+
+    if( direction == NULL )
+    {
+        return 1;
+    }
+    if( ( _rollupRead( &wm->rollupDir, level, buckets, totals ) == 0 ) || ( totals[2] == 0 ) )
+    {
+        return 1;
+    }
+    // The sums are signed, the differences of the snapshots still are
+    _vectorMean( (int32_t)totals[0], (int32_t)totals[1], (uint64_t)totals[2] * 256,
+                 direction, steadiness );
+    return 0;
+}
+
+int8_t wmGetRainRollup( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets, uint32_t *tips )
+{
+    if( tips == NULL )
+    {
+        return 1;
+    }
+    return( ( _rollupRead( &wm->rollupRain, level, buckets, tips ) == 0 ) ? 1 : 0 );
+}
+
+uint32_t wmGetRainTotal_milliIn( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets )
+{
+    uint32_t tips;
+
+    if( wmGetRainRollup( wm, level, buckets, &tips ) != 0 )
+    {
+        return 0;
+    }
+    return( tips * RAIN_BUCKET_MILLI_INCH );
+}
+
+uint32_t wmGetRainTotal_Unit( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets )
+{
+    uint32_t tips;
+
+    if( wmGetRainRollup( wm, level, buckets, &tips ) != 0 )
+    {
+        return 0;
+    }
+    return _rainMilliUnit( tips );
+}
+
+#if WEATHER_METER_USE_DOUBLE
+double wmGetWindSpeedMean_MPH( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets )
+{
+    return( _windSpeedMeanMilli( wm, level, buckets, WIND_SPEED_MILLI_MPH ) / 1000.0 );
+}
+
+double wmGetRainTotal_in( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets )
+{
+    return( wmGetRainTotal_milliIn( wm, level, buckets ) / 1000.0 );
+}
+#endif /* WEATHER_METER_USE_DOUBLE */
+#endif /* WEATHER_ROLLUP */
+#if WEATHER_METER_EVENTS
+uint8_t wmPopWeatherEvent( weatherMeter_t *wm, weatherEvent_t *event )
+{
+    weatherEventQueue_t *oldest = NULL;
+    weatherEventQueue_t *q;
+    uint32_t timestamp = 0;
+
+    // Take from whichever queue has the oldest event waiting
+    for( uint32_t i=0; i<WEATHER_EVENT_QUEUE_COUNT; i++ )
+    {
+        q = &wm->eventQueues[i];
+        if( q->head != q->tail )
+        {
+            WEATHER_METER_BARRIER();
+            if( ( oldest == NULL ) ||
+                ( (int32_t)( q->ring[q->tail & ( WEATHER_METER_EVENT_QUEUE_SIZE - 1 )].timestamp - timestamp ) < 0 ) )
+            {
+                oldest = q;
+                timestamp = q->ring[q->tail & ( WEATHER_METER_EVENT_QUEUE_SIZE - 1 )].timestamp;
+            }
+        }
+    }
+
+    if( oldest == NULL )
+    {   // Nothing waiting
+        return 0;
+    }
+
+    *event = oldest->ring[oldest->tail & ( WEATHER_METER_EVENT_QUEUE_SIZE - 1 )];
+
+    // Hand the slot back only once it's been copied
+    WEATHER_METER_BARRIER();
+    oldest->tail = oldest->tail + 1;
+    return 1;
+}
+
+uint32_t wmDrainWeatherEvents( weatherMeter_t *wm, weatherEvent_t *events, uint32_t max )
+{
+    uint32_t count = 0;
+
+    while( ( count < max ) && wmPopWeatherEvent( wm, &events[count] ) )
+    {
+        count++;
+    }
+    return count;
+}
+
+uint32_t wmGetWeatherEventDrops( weatherMeter_t *wm )
+{
+    uint32_t drops = 0;
+
+    for( uint32_t i=0; i<WEATHER_EVENT_QUEUE_COUNT; i++ )
+    {
+        drops += wm->eventQueues[i].drops;
+    }
+    return drops;
+}
+#endif /* WEATHER_METER_EVENTS */
+
+#if WEATHER_METER_SNAPSHOT
+int8_t wmGetStationSnapshot( weatherMeter_t *wm, stationSnapshot_t *snapshot )
+{
+    weatherSnapshotState_t *s = &wm->snapshot;
+    uint32_t vane;
+    uint32_t speed;
+    uint32_t rain;
+#if RAIN_BUCKET_TIPS
+    uint32_t tip;
+    uint32_t count;
+#endif
+
+    if( snapshot == NULL )
+    {
+        return 1;
+    }
+
+    // Retry if any reading was published while working the snapshot out
+    do
+    {
+        vane = s->vaneSeq;
+        speed = s->speedSeq;
+        rain = s->rainSeq;
+#if RAIN_BUCKET_TIPS
+        tip = s->tipSeq;
+#endif
+        WEATHER_METER_BARRIER();
+        snapshot->average = wm->average;
+        snapshot->direction = _classifyWindVane( wm, snapshot->average );
+        snapshot->windSpeed_cMPH = _milliToCenti( _windSpeedNowMilli( wm, WIND_SPEED_MILLI_MPH ) );
+        snapshot->rainfall_milliInPerHr = _rainfallMilli( wm, RAIN_BUCKET_MILLI_INCH, 1 );
+        snapshot->windVaneTime = s->vaneTime;
+        snapshot->windSpeedTime = s->speedTime;
+#if RAIN_BUCKET_TIPS
+        count = wm->rainTips.count;
+        snapshot->rainTime = ( count != 0 ) ? wm->rainTips.times[( count - 1 ) & ( RAIN_BUCKET_TIPS_RING - 1 )] : 0;
+#else
+        snapshot->rainTime = s->rainTime;
+#endif
+        WEATHER_METER_BARRIER();
+    } while( ( ( vane | speed | rain ) & 1 ) ||
+             ( vane != s->vaneSeq ) || ( speed != s->speedSeq ) || ( rain != s->rainSeq )
+#if RAIN_BUCKET_TIPS
+             || ( tip & 1 ) || ( tip != s->tipSeq )
+#endif
+           );
+
+    // Each reading adds 2 to its counter
+    snapshot->generation = ( vane + speed + rain ) / 2;
+#if RAIN_BUCKET_TIPS
+    snapshot->generation += tip / 2;
+#endif
+    return 0;
+}
+#endif /* WEATHER_METER_SNAPSHOT */
+
+#if WEATHER_METER_HEALTH
+void wmWindVaneBufferDone( weatherMeter_t *wm )
+{
+    wm->health.vaneDone++;
+}
+
+int8_t wmGetWeatherMeterHealth( weatherMeter_t *wm, weatherMeterHealth_t *health )
+{
+    const volatile weatherMeterHealth_t *counts = &wm->health.counts;
+
+    if( health == NULL )
+    {
+        return 1;
+    }
+
+    // Single words, each read in one access
+    health->vaneOverruns = counts->vaneOverruns;
+    health->vaneOutOfBand = counts->vaneOutOfBand;
+    health->windSpeedLate = counts->windSpeedLate;
+    health->windSpeedMissed = counts->windSpeedMissed;
+    health->rainBucketLate = counts->rainBucketLate;
+    health->rainBucketMissed = counts->rainBucketMissed;
+    health->windSpeedWraps = counts->windSpeedWraps;
+    health->rainBucketWraps = counts->rainBucketWraps;
+    return 0;
+}
+#endif /* WEATHER_METER_HEALTH */
+
+#if WEATHER_METER_PROFILE
+int8_t initWeatherProfile( void )
+{
+#if defined( DWT_CTRL_CYCCNTENA_Msk ) && defined( CoreDebug_DEMCR_TRCENA_Msk )
+    // Turn the cycle counter on, it runs at the core clock
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    return setWeatherProfileClock( _profileCycles, SystemCoreClock );
+#else
+    return setWeatherProfileClock( HAL_GetTick, 1000 );
+#endif
+}
+
+int8_t setWeatherProfileClock( weatherMeterClock_t clock, uint32_t hz )
+{
+    if( ( clock == NULL ) || ( hz == 0 ) )
+    {
+        return 1;
+    }
+    _profile.clock = clock;
+    _profile.hz = hz;
+    resetWeatherProfile();
+    return 0;
+}
+
+int8_t getWeatherProfile( weatherProfileId_t id, weatherProfile_t *profile )
+{
+    const weatherProfileEntry_t *p;
+    uint32_t updates;
+
+    if( ( id >= WEATHER_PROFILE_COUNT ) || ( profile == NULL ) )
+    {
+        return 1;
+    }
+
+    // Retry if the function finished a call while copying
+    p = &_profile.entries[id];
+    do
+    {
+        updates = p->updates;
+        WEATHER_METER_BARRIER();
+        profile->count = p->count;
+        profile->min = p->min;
+        profile->max = p->max;
+        profile->total = p->total;
+        memcpy( profile->histogram, p->histogram, sizeof( profile->histogram ) );
+        WEATHER_METER_BARRIER();
+    } while( ( updates & 1 ) || ( updates != p->updates ) );
+
+    profile->mean = ( profile->count != 0 ) ? (uint32_t)( profile->total / profile->count ) : 0;
+    profile->hz = _profile.hz;
+    return 0;
+}
+
+void resetWeatherProfile( void )
+{
+    weatherProfileEntry_t *p;
+    uint32_t i;
+    uint32_t key;
+
+    for( i=0; i<WEATHER_PROFILE_COUNT; i++ )
+    {
+        p = &_profile.entries[i];
+        WEATHER_METER_LOCK( key );
+        p->updates++;
+        WEATHER_METER_BARRIER();
+        p->count = 0;
+        p->min = 0;
+        p->max = 0;
+        p->total = 0;
+        memset( p->histogram, 0, sizeof( p->histogram ) );
+        WEATHER_METER_BARRIER();
+        p->updates++;
+        WEATHER_METER_UNLOCK( key );
+    }
+}
+#endif /* WEATHER_METER_PROFILE */
+
+/*
+ * The default station, for the functions without a station argument
+ */
+int8_t setWeatherMeterClock( weatherMeterClock_t clock, uint32_t hz )
+{
+    return wmSetWeatherMeterClock( &_weatherMeter, clock, hz );
+}
+
+int8_t initWindVane( ADC_HandleTypeDef *hadc )
+{
+    return wmInitWindVane( &_weatherMeter, hadc );
+}
+
+void processWindVane( void )
+{
+    wmProcessWindVane( &_weatherMeter );
+}
+
+#if WIND_VANE_DOUBLE_BUFFER
+void processWindVaneFirstHalf( void )
+{
+    wmProcessWindVaneFirstHalf( &_weatherMeter );
+}
+
+void processWindVaneSecondHalf( void )
+{
+    wmProcessWindVaneSecondHalf( &_weatherMeter );
+}
+#endif /* WIND_VANE_DOUBLE_BUFFER */
+
+windVaneDir_t getWindVaneDirection( void )
+{
+    return wmGetWindVaneDirection( &_weatherMeter );
+}
+
+int8_t setWindVaneTables( const uint32_t *values, const uint8_t *lut )
+{
+    return wmSetWindVaneTables( &_weatherMeter, values, lut );
+}
+
+#if WIND_VANE_USE_LUT && !WIND_VANE_EXTERNAL_TABLES
+void buildWindVaneLut( void )
+{
+    wmBuildWindVaneLut( &_weatherMeter );
+}
+#endif /* WIND_VANE_USE_LUT && !WIND_VANE_EXTERNAL_TABLES */
+
+#if WIND_VANE_DEBOUNCE
+windVaneDir_t getWindVaneDirectionDebounced( void )
+{
+    return wmGetWindVaneDirectionDebounced( &_weatherMeter );
+}
+
+uint32_t getWindVaneDirChangeCount( void )
+{
+    return wmGetWindVaneDirChangeCount( &_weatherMeter );
+}
+
+uint8_t getWindVaneDirChanged( void )
+{
+    return wmGetWindVaneDirChanged( &_weatherMeter );
+}
+#endif /* WIND_VANE_DEBOUNCE */
+
+#if WIND_VANE_VOTE
+windVaneDir_t getWindVaneVoteDirection( uint8_t *share )
+{
+    return wmGetWindVaneVoteDirection( &_weatherMeter, share );
+}
+#endif /* WIND_VANE_VOTE */
+
+#if WIND_VANE_VECTOR_AVG
+int8_t getWindVaneMeanDirection( windVaneWindow_t window, uint16_t *direction,
+                                 uint16_t *steadiness )
+{
+    return wmGetWindVaneMeanDirection( &_weatherMeter, window, direction, steadiness );
+}
+#endif /* WIND_VANE_VECTOR_AVG */
+
+const uint32_t* getWindVaneValues( void )
+{
+    return wmGetWindVaneValues( &_weatherMeter );
+}
+
+#if WIND_VANE_AUTOCAL
+void resetWindVaneAutoCal( void )
+{
+    wmResetWindVaneAutoCal( &_weatherMeter );
+}
+#endif /* WIND_VANE_AUTOCAL */
+
+#if WIND_SPEED_CAPTURE
+int8_t initWindSpeedCapture( TIM_HandleTypeDef *htim, uint32_t channel )
+{
+    return wmInitWindSpeedCapture( &_weatherMeter, htim, channel );
+}
+
+uint32_t getWindSpeedPeriod( void )
+{
+    return wmGetWindSpeedPeriod( &_weatherMeter );
+}
+#else
+int8_t initWindSpeed( TIM_HandleTypeDef *htim )
+{
+    return wmInitWindSpeed( &_weatherMeter, htim );
+}
+#endif /* WIND_SPEED_CAPTURE */
+
+void processWindSpeed( void )
+{
+    wmProcessWindSpeed( &_weatherMeter );
+}
+
+uint32_t getWindSpeedCount( void )
+{
+    return wmGetWindSpeedCount( &_weatherMeter );
+}
+
+uint32_t getWindSpeed_cMPH( void )
+{
+    return wmGetWindSpeed_cMPH( &_weatherMeter );
+}
+
+uint32_t getWindSpeed_Q16( void )
+{
+    return wmGetWindSpeed_Q16( &_weatherMeter );
+}
+
+uint32_t getWindSpeed_Unit( void )
+{
+    return wmGetWindSpeed_Unit( &_weatherMeter );
+}
+
+#if WEATHER_METER_USE_DOUBLE
+double getWindSpeed_MPH( void )
+{
+    return wmGetWindSpeed_MPH( &_weatherMeter );
+}
+#endif
+
+#if WIND_GUST
+uint32_t getWindGust_cMPH( void )
+{
+    return wmGetWindGust_cMPH( &_weatherMeter );
+}
+
+int8_t getWindGustPeak( windGust_t *gust )
+{
+    return wmGetWindGustPeak( &_weatherMeter, gust );
+}
+
+uint32_t getWindGustPeak_cMPH( void )
+{
+    return wmGetWindGustPeak_cMPH( &_weatherMeter );
+}
+
+uint32_t getWindGust_Unit( void )
+{
+    return wmGetWindGust_Unit( &_weatherMeter );
+}
+
+uint32_t getWindGustPeak_Unit( void )
+{
+    return wmGetWindGustPeak_Unit( &_weatherMeter );
+}
+
+#if WEATHER_METER_USE_DOUBLE
+double getWindGust_MPH( void )
+{
+    return wmGetWindGust_MPH( &_weatherMeter );
+}
+
+double getWindGustPeak_MPH( void )
+{
+    return wmGetWindGustPeak_MPH( &_weatherMeter );
+}
+#endif /* WEATHER_METER_USE_DOUBLE */
+#endif /* WIND_GUST */
+
+#if RAIN_BUCKET_TIPS
+int8_t initRainBucketTips( void )
+{
+    return wmInitRainBucketTips( &_weatherMeter );
+}
+
+void rainBucketTip( void )
+{
+    wmRainBucketTip( &_weatherMeter );
+}
+
+uint32_t getRainBucketTips( void )
+{
+    return wmGetRainBucketTips( &_weatherMeter );
+}
+#else
+int8_t initRainBucket( TIM_HandleTypeDef *htim )
+{
+    return wmInitRainBucket( &_weatherMeter, htim );
+}
+#endif /* RAIN_BUCKET_TIPS */
+
+void processRainBucket( void )
+{
+    wmProcessRainBucket( &_weatherMeter );
+}
+
+uint32_t getRainfall_milliInPerHr( void )
+{
+    return wmGetRainfall_milliInPerHr( &_weatherMeter );
+}
+
+uint32_t getRainfall_Unit( void )
+{
+    return wmGetRainfall_Unit( &_weatherMeter );
+}
+
+#if WEATHER_METER_USE_DOUBLE
+double getRainfall_inperhr( void )
+{
+    return wmGetRainfall_inperhr( &_weatherMeter );
+}
+#endif
+
+#if RAIN_TOTALS
+int8_t getRainTotals( rainTotals_t *totals )
+{
+    return wmGetRainTotals( &_weatherMeter, totals );
+}
+
+void resetRainDay( void )
+{
+    wmResetRainDay( &_weatherMeter );
+}
+
+void setRainDayHook( rainDayHook_t hook )
+{
+    wmSetRainDayHook( &_weatherMeter, hook );
+}
+#endif /* RAIN_TOTALS */
+
+#if WEATHER_ROLLUP
+int8_t getWindSpeedRollup( weatherRollupLevel_t level, uint16_t buckets,
+                           uint32_t *count, uint32_t *ms )
+{
+    return wmGetWindSpeedRollup( &_weatherMeter, level, buckets, count, ms );
+}
+
+uint32_t getWindSpeedMean_cMPH( weatherRollupLevel_t level, uint16_t buckets )
+{
+    return wmGetWindSpeedMean_cMPH( &_weatherMeter, level, buckets );
+}
+
+uint32_t getWindSpeedMean_Unit( weatherRollupLevel_t level, uint16_t buckets )
+{
+    return wmGetWindSpeedMean_Unit( &_weatherMeter, level, buckets );
+}
+
+int8_t getWindDirRollup( weatherRollupLevel_t level, uint16_t buckets,
+                         uint16_t *direction, uint16_t *steadiness )
+{
+    return wmGetWindDirRollup( &_weatherMeter, level, buckets, direction, steadiness );
+}
+
+int8_t getRainRollup( weatherRollupLevel_t level, uint16_t buckets, uint32_t *tips )
+{
+    return wmGetRainRollup( &_weatherMeter, level, buckets, tips );
+}
+
+uint32_t getRainTotal_milliIn( weatherRollupLevel_t level, uint16_t buckets )
+{
+    return wmGetRainTotal_milliIn( &_weatherMeter, level, buckets );
+}
+
+uint32_t getRainTotal_Unit( weatherRollupLevel_t level, uint16_t buckets )
+{
+    return wmGetRainTotal_Unit( &_weatherMeter, level, buckets );
+}
+
+#if WEATHER_METER_USE_DOUBLE
+double getWindSpeedMean_MPH( weatherRollupLevel_t level, uint16_t buckets )
+{
+    return wmGetWindSpeedMean_MPH( &_weatherMeter, level, buckets );
+}
+
+double getRainTotal_in( weatherRollupLevel_t level, uint16_t buckets )
+{
+    return wmGetRainTotal_in( &_weatherMeter, level, buckets );
+}
+#endif /* WEATHER_METER_USE_DOUBLE */
+#endif /* WEATHER_ROLLUP */
+
+#if WEATHER_METER_EVENTS
+uint8_t popWeatherEvent( weatherEvent_t *event )
+{
+    return wmPopWeatherEvent( &_weatherMeter, event );
+}
+
+uint32_t drainWeatherEvents( weatherEvent_t *events, uint32_t max )
+{
+    return wmDrainWeatherEvents( &_weatherMeter, events, max );
+}
+
+uint32_t getWeatherEventDrops( void )
+{
+    return wmGetWeatherEventDrops( &_weatherMeter );
+}
+#endif /* WEATHER_METER_EVENTS */
+
+#if WEATHER_METER_SNAPSHOT
+int8_t getStationSnapshot( stationSnapshot_t *snapshot )
+{
+    return wmGetStationSnapshot( &_weatherMeter, snapshot );
+}
+#endif /* WEATHER_METER_SNAPSHOT */
+
+#if WEATHER_METER_HEALTH
+void windVaneBufferDone( void )
+{
+    wmWindVaneBufferDone( &_weatherMeter );
+}
+
+int8_t getWeatherMeterHealth( weatherMeterHealth_t *health )
+{
+    return wmGetWeatherMeterHealth( &_weatherMeter, health );
+}
+#endif /* WEATHER_METER_HEALTH */
+
 // End of file - weatherMeter.c
@@ -37,45 +37,1309 @@
  *          you want the ADC to take before the DMA transfer is 
  *          initiated
  */
+#ifndef WIND_VANE_ADC_BUF_SIZE
 #define WIND_VANE_ADC_BUF_SIZE 64
+#endif
+/**
+ * @brief   WIND_VANE_ADC_HALFWORD - set this to 1 to store the ADC
+ *          samples as 16 bit halfwords instead of 32 bit words.  This
+ *          halves the buffer RAM and the DMA bus traffic, the DMA channel
+ *          must be configured for halfword memory data width.  Samples
+ *          must be right aligned 12 bit values, two of them are summed
+ *          per instruction
+ */
+#ifndef WIND_VANE_ADC_HALFWORD
+#define WIND_VANE_ADC_HALFWORD 0
+#endif
+/**
+ * @brief   WIND_VANE_CODE_BAND - this value will set the window size
+ *          when measuring the ADC.  Adjust this value to compensate
+ *          for noise in the system
+ */
+#define WIND_VANE_CODE_BAND  20
+/**
+ * @brief   WIND_VANE_DOUBLE_BUFFER - set this to 1 to process the ADC
+ *          buffer in two halves (ping-pong) from the DMA half transfer
+ *          and transfer complete callbacks.  Each half holds
+ *          WIND_VANE_ADC_BUF_SIZE / 2 samples and only the half the DMA
+ *          has finished with is averaged, so it has a full half period
+ *          of processing time before it is overwritten
+ */
+#ifndef WIND_VANE_DOUBLE_BUFFER
+#define WIND_VANE_DOUBLE_BUFFER 0
+#endif
+/**
+ * @brief   WIND_VANE_HAL_CALLBACKS - set this to 1 to let the library
+ *          define HAL_ADC_ConvHalfCpltCallback() and
+ *          HAL_ADC_ConvCpltCallback().  Leave it at 0 if your application
+ *          already defines them and call processWindVaneFirstHalf() and
+ *          processWindVaneSecondHalf() from there instead.  Only used
+ *          when WIND_VANE_DOUBLE_BUFFER is 1
+ */
+#ifndef WIND_VANE_HAL_CALLBACKS
+#define WIND_VANE_HAL_CALLBACKS 0
+#endif
+
+/**
+ * @brief   WIND_VANE_ADC_BITS - the resolution of the ADC reading the
+ *          wind vane
+ */
+#ifndef WIND_VANE_ADC_BITS
+#define WIND_VANE_ADC_BITS 12
+#endif
+/**
+ * @brief   WIND_VANE_USE_LUT - set this to 1 to classify the ADC average
+ *          with a lookup table instead of scanning the values table on
+ *          every call.  The table holds one direction per ADC code packed
+ *          two to a byte (2 KB for a 12 bit ADC, per station) and is built
+ *          by initWindVane()
+ */
+#ifndef WIND_VANE_USE_LUT
+#define WIND_VANE_USE_LUT 0
+#endif
+/**
+ * @brief   WIND_VANE_EXTERNAL_TABLES - set this to 1 when the lookup
+ *          table is generated ahead of time (see weatherMeterTables.hpp)
+ *          and installed with setWindVaneTables().  The library then
+ *          keeps no lookup table of its own in RAM.  Only used when
+ *          WIND_VANE_USE_LUT is 1
+ */
+#ifndef WIND_VANE_EXTERNAL_TABLES
+#define WIND_VANE_EXTERNAL_TABLES 0
+#endif
+/**
+ * @brief   WIND_VANE_LUT_SIZE - the size in bytes of the lookup table
+ */
+#define WIND_VANE_LUT_SIZE ( ( 1UL << WIND_VANE_ADC_BITS ) / 2 )
+
+/**
+ * @brief   WIND_VANE_AUTOCAL - set this to 1 to let the library track
+ *          drift of the wind vane values (temperature, cable resistance)
+ *          and adjust the values table itself.  Each processed buffer
+ *          pulls the nearest value towards its average, if the average
+ *          lands in a well populated part of a coarse histogram of recent
+ *          averages.  The adjusted table is swapped in every
+ *          WIND_VANE_AUTOCAL_PUBLISH buffers.  The cost per buffer is
+ *          constant, so it can run in the DMA callback
+ */
+#ifndef WIND_VANE_AUTOCAL
+#define WIND_VANE_AUTOCAL 0
+#endif
+/**
+ * @brief   WIND_VANE_AUTOCAL_BIN_SHIFT - ADC codes per histogram bin, as
+ *          a power of 2.  The histogram takes 2 bytes per bin
+ */
+#ifndef WIND_VANE_AUTOCAL_BIN_SHIFT
+#define WIND_VANE_AUTOCAL_BIN_SHIFT 4
+#endif
+/**
+ * @brief   WIND_VANE_AUTOCAL_MIN_HITS - the histogram count a bin needs
+ *          before averages landing in it move a value.  Keeps the vane
+ *          swinging through a position from dragging its value along
+ */
+#ifndef WIND_VANE_AUTOCAL_MIN_HITS
+#define WIND_VANE_AUTOCAL_MIN_HITS 8
+#endif
+/**
+ * @brief   WIND_VANE_AUTOCAL_RATE_SHIFT - a value moves 1/2^n of the way
+ *          to each average that pulls it
+ */
+#ifndef WIND_VANE_AUTOCAL_RATE_SHIFT
+#define WIND_VANE_AUTOCAL_RATE_SHIFT 4
+#endif
+/**
+ * @brief   WIND_VANE_AUTOCAL_CAPTURE - how far in ADC codes an average
+ *          can be from a value and still pull it
+ */
+#ifndef WIND_VANE_AUTOCAL_CAPTURE
+#define WIND_VANE_AUTOCAL_CAPTURE ( 3 * WIND_VANE_CODE_BAND )
+#endif
+/**
+ * @brief   WIND_VANE_AUTOCAL_MAX_DRIFT - how far in ADC codes a value
+ *          may move away from the table it started from
+ */
+#ifndef WIND_VANE_AUTOCAL_MAX_DRIFT
+#define WIND_VANE_AUTOCAL_MAX_DRIFT ( 5 * WIND_VANE_CODE_BAND )
+#endif
+/**
+ * @brief   WIND_VANE_AUTOCAL_PUBLISH - processed buffers between swaps of
+ *          the adjusted values table
+ */
+#ifndef WIND_VANE_AUTOCAL_PUBLISH
+#define WIND_VANE_AUTOCAL_PUBLISH 64
+#endif
+/**
+ * @brief   WIND_VANE_AUTOCAL_LUT_SLICE - ADC codes of the lookup table
+ *          rebuilt per processed buffer after a swap
+ */
+#ifndef WIND_VANE_AUTOCAL_LUT_SLICE
+#define WIND_VANE_AUTOCAL_LUT_SLICE 64
+#endif
+
+#if WIND_VANE_AUTOCAL && WIND_VANE_USE_LUT && WIND_VANE_EXTERNAL_TABLES
+#error "WIND_VANE_AUTOCAL needs a lookup table in RAM, it can't be used with WIND_VANE_EXTERNAL_TABLES"
+#endif
+
+/**
+ * @brief   WIND_VANE_ESTIMATOR - how a buffer is reduced to one reading.
+ *          WIND_VANE_ESTIMATOR_MEAN is the plain average.
+ *          WIND_VANE_ESTIMATOR_MEDIAN and WIND_VANE_ESTIMATOR_IQM (mean
+ *          of the middle half of the samples) ignore spikes.  Both use
+ *          two counting passes over the samples, no sorting and no
+ *          branches per sample, so the time taken only depends on the
+ *          buffer size:
+ *
+ *          samples     sample reads    histogram bins scanned
+ *          N           2N              at most 2 x 64 + 2 x 64
+ *          64          128             256
+ *          256         512             256
+ *          512         1024            256
+ *
+ *          Two rank searches over the 64 coarse bins and two sums over
+ *          the fine bins of a 12 bit ADC make the 256, on top of which
+ *          the 896 bytes of histograms are cleared for every block.
+ *          They are kept per station
+ */
+#define WIND_VANE_ESTIMATOR_MEAN    0
+#define WIND_VANE_ESTIMATOR_MEDIAN  1
+#define WIND_VANE_ESTIMATOR_IQM     2
+#ifndef WIND_VANE_ESTIMATOR
+#define WIND_VANE_ESTIMATOR WIND_VANE_ESTIMATOR_MEAN
+#endif
+/**
+ * @brief   WIND_VANE_VOTE - set this to 1 to also classify every sample
+ *          of a buffer and take the direction most samples agree on.  A
+ *          buffer where the vane sits between two positions or swings
+ *          through a sector still gives a direction, where its average
+ *          may fall between bands.  Needs WIND_VANE_USE_LUT, so each
+ *          sample costs one table load and one increment
+ */
+#ifndef WIND_VANE_VOTE
+#define WIND_VANE_VOTE 0
+#endif
+
+#if WIND_VANE_VOTE && !WIND_VANE_USE_LUT
+#error "WIND_VANE_VOTE classifies every sample with the lookup table, set WIND_VANE_USE_LUT to 1"
+#endif
+/**
+ * @brief   WIND_VANE_DEBOUNCE - set this to 1 to keep a debounced wind
+ *          direction.  A new direction is only taken once it has been
+ *          read WIND_VANE_DEBOUNCE_COUNT processed buffers in a row, or
+ *          has been held for WIND_VANE_DEBOUNCE_DWELL_MS, whichever comes
+ *          first.  Stops the output flickering between two neighbours
+ *          when the vane hovers on a sector edge
+ */
+#ifndef WIND_VANE_DEBOUNCE
+#define WIND_VANE_DEBOUNCE 0
+#endif
+/**
+ * @brief   WIND_VANE_DEBOUNCE_COUNT - consecutive readings needed to
+ *          change direction, 0 to only use the dwell time
+ */
+#ifndef WIND_VANE_DEBOUNCE_COUNT
+#define WIND_VANE_DEBOUNCE_COUNT 3
+#endif
+/**
+ * @brief   WIND_VANE_DEBOUNCE_DWELL_MS - time in ms a new direction must
+ *          be held to change direction, 0 to only use the count
+ */
+#ifndef WIND_VANE_DEBOUNCE_DWELL_MS
+#define WIND_VANE_DEBOUNCE_DWELL_MS 0
+#endif
+
+#if WIND_VANE_DEBOUNCE && ( WIND_VANE_DEBOUNCE_COUNT == 0 ) && ( WIND_VANE_DEBOUNCE_DWELL_MS == 0 )
+#error "WIND_VANE_DEBOUNCE needs a count, a dwell time or both"
+#endif
+
+/**
+ * @brief   WIND_VANE_VECTOR_AVG - set this to 1 to keep a vector average
+ *          of the wind direction over a short and a long window (e.g. 2
+ *          and 10 minutes).  Each direction is added as a unit vector,
+ *          so averaging across N works.  The windows are made of blocks
+ *          of WIND_VANE_VECTOR_BLOCK processed buffers, with running sums
+ *          so each buffer costs the same whatever the window lengths
+ */
+#ifndef WIND_VANE_VECTOR_AVG
+#define WIND_VANE_VECTOR_AVG 0
+#endif
+/**
+ * @brief   WIND_VANE_VECTOR_BLOCK - processed buffers per block.  Set it
+ *          so a block spans a convenient time, e.g. 10 seconds
+ */
+#ifndef WIND_VANE_VECTOR_BLOCK
+#define WIND_VANE_VECTOR_BLOCK 10
+#endif
+/**
+ * @brief   WIND_VANE_VECTOR_SHORT_BLOCKS - blocks in the short window
+ */
+#ifndef WIND_VANE_VECTOR_SHORT_BLOCKS
+#define WIND_VANE_VECTOR_SHORT_BLOCKS 12
+#endif
+/**
+ * @brief   WIND_VANE_VECTOR_LONG_BLOCKS - blocks in the long window.  The
+ *          library keeps 10 bytes of RAM per block
+ */
+#ifndef WIND_VANE_VECTOR_LONG_BLOCKS
+#define WIND_VANE_VECTOR_LONG_BLOCKS 60
+#endif
+
+#if ( WIND_VANE_ESTIMATOR != WIND_VANE_ESTIMATOR_MEAN ) && ( WIND_VANE_ADC_BITS < 6 )
+#error "WIND_VANE_ESTIMATOR needs an ADC of at least 6 bits"
+#endif
+#if WIND_VANE_VECTOR_AVG && ( WIND_VANE_VECTOR_SHORT_BLOCKS > WIND_VANE_VECTOR_LONG_BLOCKS )
+#error "WIND_VANE_VECTOR_SHORT_BLOCKS can't be longer than WIND_VANE_VECTOR_LONG_BLOCKS"
+#endif
+#if WIND_VANE_VECTOR_AVG && ( WIND_VANE_VECTOR_BLOCK * WIND_VANE_VECTOR_LONG_BLOCKS > 65535 )
+#error "The long vector average window must be 65535 buffers or less"
+#endif
+
+#if WIND_VANE_DOUBLE_BUFFER && ( WIND_VANE_ADC_BUF_SIZE % 2 )
+#error "WIND_VANE_ADC_BUF_SIZE must be even when WIND_VANE_DOUBLE_BUFFER is used"
+#endif
+
+/**
+ * @brief   WEATHER_METER_USE_DOUBLE - set this to 0 to leave out the
+ *          double versions of the conversion functions.  The library
+ *          converts in integers, so without them no soft-float code is
+ *          pulled in on parts without an FPU
+ */
+#ifndef WEATHER_METER_USE_DOUBLE
+#define WEATHER_METER_USE_DOUBLE 1
+#endif
+/**
+ * @brief   WIND_SPEED_MILLI_MPH - thousandths of a MPH per anemometer
+ *          count per second, 1.492 MPH from the datasheet
+ */
+#ifndef WIND_SPEED_MILLI_MPH
+#define WIND_SPEED_MILLI_MPH 1492UL
+#endif
+/**
+ * @brief   RAIN_BUCKET_MILLI_INCH - thousandths of an inch of rain per
+ *          rain bucket tip, 0.011" from the datasheet
+ */
+#ifndef RAIN_BUCKET_MILLI_INCH
+#define RAIN_BUCKET_MILLI_INCH 11UL
+#endif
+
+#define WIND_SPEED_UNIT_MPH         0
+#define WIND_SPEED_UNIT_KMH         1
+#define WIND_SPEED_UNIT_MS          2
+#define WIND_SPEED_UNIT_KNOTS       3
+#define WIND_SPEED_UNIT_BEAUFORT    4
+/**
+ * @brief   WIND_SPEED_UNIT - the unit the _Unit wind speed functions
+ *          return, in hundredths, or the Beaufort force.  The unit is
+ *          folded into the conversion factor WIND_SPEED_MILLI_UNIT at
+ *          compile time, so it costs the same as MPH
+ */
+#ifndef WIND_SPEED_UNIT
+#define WIND_SPEED_UNIT WIND_SPEED_UNIT_MPH
+#endif
+
+#if WIND_SPEED_UNIT == WIND_SPEED_UNIT_MPH
+#define WIND_SPEED_MILLI_UNIT   WIND_SPEED_MILLI_MPH
+#define WIND_SPEED_UNIT_STR     "MPH"
+#elif WIND_SPEED_UNIT == WIND_SPEED_UNIT_KMH
+#define WIND_SPEED_MILLI_UNIT   ( (uint32_t)( ( WIND_SPEED_MILLI_MPH * 1609344ULL + 500000 ) / 1000000 ) )
+#define WIND_SPEED_UNIT_STR     "km/h"
+#elif WIND_SPEED_UNIT == WIND_SPEED_UNIT_MS
+#define WIND_SPEED_MILLI_UNIT   ( (uint32_t)( ( WIND_SPEED_MILLI_MPH * 44704ULL + 50000 ) / 100000 ) )
+#define WIND_SPEED_UNIT_STR     "m/s"
+#elif WIND_SPEED_UNIT == WIND_SPEED_UNIT_KNOTS
+#define WIND_SPEED_MILLI_UNIT   ( (uint32_t)( ( WIND_SPEED_MILLI_MPH * 1609344ULL + 926000 ) / 1852000 ) )
+#define WIND_SPEED_UNIT_STR     "kn"
+#elif WIND_SPEED_UNIT == WIND_SPEED_UNIT_BEAUFORT
+// The force is looked up from m/s
+#define WIND_SPEED_MILLI_UNIT   ( (uint32_t)( ( WIND_SPEED_MILLI_MPH * 44704ULL + 50000 ) / 100000 ) )
+#define WIND_SPEED_UNIT_STR     "Bft"
+#else
+#error "Unknown WIND_SPEED_UNIT"
+#endif
+
+#define RAIN_UNIT_INCH  0
+#define RAIN_UNIT_MM    1
+/**
+ * @brief   RAIN_UNIT - the unit the _Unit rain functions return, in
+ *          thousandths.  The tip size is converted exactly, 25.4 mm to
+ *          the inch is 127 / 5
+ */
+#ifndef RAIN_UNIT
+#define RAIN_UNIT RAIN_UNIT_INCH
+#endif
+
+#if RAIN_UNIT == RAIN_UNIT_INCH
+#define RAIN_MILLI_UNIT_NUM     RAIN_BUCKET_MILLI_INCH
+#define RAIN_MILLI_UNIT_DEN     1
+#define RAIN_UNIT_STR           "in"
+#elif RAIN_UNIT == RAIN_UNIT_MM
+#define RAIN_MILLI_UNIT_NUM     ( RAIN_BUCKET_MILLI_INCH * 127 )
+#define RAIN_MILLI_UNIT_DEN     5
+#define RAIN_UNIT_STR           "mm"
+#else
+#error "Unknown RAIN_UNIT"
+#endif
+
+/**
+ * @brief   WEATHER_METER_FREE_RUNNING - set this to 1 to leave the
+ *          anemometer and rain bucket counters running and take the
+ *          difference from the previous reading, instead of reading and
+ *          clearing them.  No pulse arriving between the read and the
+ *          clear is lost.  The counters must count over their full
+ *          range (period / ARR set to the maximum)
+ */
+#ifndef WEATHER_METER_FREE_RUNNING
+#define WEATHER_METER_FREE_RUNNING 0
+#endif
+/**
+ * @brief   WEATHER_METER_COUNTER_BITS - the width of the counters, 16 for
+ *          the STM32F1 timers.  There must be fewer than 2^bits pulses
+ *          between two process calls
+ */
+#ifndef WEATHER_METER_COUNTER_BITS
+#define WEATHER_METER_COUNTER_BITS 16
+#endif
+#define WEATHER_METER_COUNTER_MASK ( (uint32_t)( ( 1ULL << WEATHER_METER_COUNTER_BITS ) - 1 ) )
+
+/**
+ * @brief   WIND_SPEED_CAPTURE - set this to 1 to measure the anemometer
+ *          with input capture instead of counting.  The timer timestamps
+ *          every pulse into a DMA ring and the speed comes from the time
+ *          between pulses, so it has a far finer resolution than a count
+ *          per second and updates with every pulse.  With several pulses
+ *          per processWindSpeed() call their average period is used, which
+ *          amounts to counting.  With none for WIND_SPEED_CAPTURE_STALL_MS
+ *          the wind speed is 0.  Configure the timer channel for input
+ *          capture, circular DMA with halfword memory width and an input
+ *          filter long enough to hide the reed switch bounce
+ */
+#ifndef WIND_SPEED_CAPTURE
+#define WIND_SPEED_CAPTURE 0
+#endif
+/**
+ * @brief   WIND_SPEED_CAPTURE_TICK_HZ - the rate the capture timer counts
+ *          at, set by its prescaler.  The timer must count over its full
+ *          16 bit range
+ */
+#ifndef WIND_SPEED_CAPTURE_TICK_HZ
+#define WIND_SPEED_CAPTURE_TICK_HZ 10000
+#endif
+/**
+ * @brief   WIND_SPEED_CAPTURE_BUF_SIZE - pulses the DMA ring holds.  When
+ *          more pulses than that come between processWindSpeed() calls the
+ *          ring laps, the speed then comes from the rate over the ring and
+ *          the count from that rate over the interval, and the lap counts
+ *          as a windSpeedWraps of WEATHER_METER_HEALTH
+ */
+#ifndef WIND_SPEED_CAPTURE_BUF_SIZE
+#define WIND_SPEED_CAPTURE_BUF_SIZE 32
+#endif
+/**
+ * @brief   WIND_SPEED_CAPTURE_STALL_MS - time in ms without a pulse after
+ *          which the wind is calm
+ */
+#ifndef WIND_SPEED_CAPTURE_STALL_MS
+#define WIND_SPEED_CAPTURE_STALL_MS 5000
+#endif
+
+#if WIND_SPEED_CAPTURE && ( WIND_SPEED_CAPTURE_BUF_SIZE < 4 )
+#error "WIND_SPEED_CAPTURE_BUF_SIZE must hold at least 4 pulses"
+#endif
+#if WIND_SPEED_CAPTURE && ( ( WIND_SPEED_CAPTURE_STALL_MS * WIND_SPEED_CAPTURE_TICK_HZ ) / 1000 > 65535 )
+#error "WIND_SPEED_CAPTURE_STALL_MS must be shorter than one wrap of the capture timer"
+#endif
+
+/**
+ * @brief   WIND_GUST - set this to 1 to track wind gusts, WMO style.
+ *          Each processWindSpeed() call (once a second) updates the
+ *          running sum of the last WIND_GUST_SAMPLES counts, scaled to
+ *          WIND_GUST_SAMPLES seconds by the time they took, the gust,
+ *          and the highest gust of the last WIND_GUST_PEAK_MS with the
+ *          time and the wind vane direction it happened at.  The peak
+ *          is kept with a monotonic queue, so an update is amortized
+ *          O(1) and the memory is fixed
+ */
+#ifndef WIND_GUST
+#define WIND_GUST 0
+#endif
+/**
+ * @brief   WIND_GUST_SAMPLES - samples averaged into a gust, 3 for the
+ *          WMO 3 second gust
+ */
+#ifndef WIND_GUST_SAMPLES
+#define WIND_GUST_SAMPLES 3
+#endif
+/**
+ * @brief   WIND_GUST_PEAK_MS - the window the peak gust is taken over
+ */
+#ifndef WIND_GUST_PEAK_MS
+#define WIND_GUST_PEAK_MS 600000UL
+#endif
+/**
+ * @brief   WIND_GUST_QUEUE_SIZE - gusts the peak queue holds, 8 bytes
+ *          each.  One per sample in the peak window makes it exact, if
+ *          it's shorter the peak may expire early after a long lull
+ */
+#ifndef WIND_GUST_QUEUE_SIZE
+#define WIND_GUST_QUEUE_SIZE 600
+#endif
+
+/**
+ * @brief   RAIN_BUCKET_TIPS - set this to 1 to count the rain bucket with
+ *          an interrupt instead of a timer.  Call rainBucketTip() from the
+ *          EXTI interrupt of the rain bucket pin, it timestamps the tip
+ *          into a ring.  The rain rate comes from the time between the
+ *          last tips and decays to 0 while no tip comes, so nothing has
+ *          to poll.  processRainBucket() is only needed for the rollup
+ */
+#ifndef RAIN_BUCKET_TIPS
+#define RAIN_BUCKET_TIPS 0
+#endif
+/**
+ * @brief   RAIN_BUCKET_TIPS_RING - tip times kept, a power of 2
+ */
+#ifndef RAIN_BUCKET_TIPS_RING
+#define RAIN_BUCKET_TIPS_RING 16
+#endif
+/**
+ * @brief   RAIN_BUCKET_TIPS_AVERAGE - intervals between tips the rain
+ *          rate is averaged over, fewer than RAIN_BUCKET_TIPS_RING
+ */
+#ifndef RAIN_BUCKET_TIPS_AVERAGE
+#define RAIN_BUCKET_TIPS_AVERAGE 4
+#endif
+/**
+ * @brief   RAIN_BUCKET_TIPS_TIMEOUT_MS - the rain rate is 0 after this
+ *          long without a tip
+ */
+#ifndef RAIN_BUCKET_TIPS_TIMEOUT_MS
+#define RAIN_BUCKET_TIPS_TIMEOUT_MS 3600000UL
+#endif
+/**
+ * @brief   RAIN_BUCKET_TIPS_DEBOUNCE_MS - tips closer than this to the
+ *          previous one are switch bounce and ignored
+ */
+#ifndef RAIN_BUCKET_TIPS_DEBOUNCE_MS
+#define RAIN_BUCKET_TIPS_DEBOUNCE_MS 50
+#endif
+
+#if RAIN_BUCKET_TIPS && ( RAIN_BUCKET_TIPS_RING & ( RAIN_BUCKET_TIPS_RING - 1 ) )
+#error "RAIN_BUCKET_TIPS_RING must be a power of 2"
+#endif
+#if RAIN_BUCKET_TIPS && ( ( RAIN_BUCKET_TIPS_AVERAGE < 1 ) || ( RAIN_BUCKET_TIPS_AVERAGE >= RAIN_BUCKET_TIPS_RING ) )
+#error "RAIN_BUCKET_TIPS_AVERAGE must be from 1 to RAIN_BUCKET_TIPS_RING - 1"
+#endif
+
+/**
+ * @brief   RAIN_TOTALS - set this to 1 to accumulate the rain from
+ *          processRainBucket(): the tips since start in 64 bits, the last
+ *          hour in 1 minute steps, the last 24 hours in 15 minute steps,
+ *          the day so far and rain events.  Every total is a running sum,
+ *          reading them with getRainTotals() is O(1)
+ */
+#ifndef RAIN_TOTALS
+#define RAIN_TOTALS 0
+#endif
+/**
+ * @brief   RAIN_TOTALS_DAY_MS - set this to reset the day's total every
+ *          so many milliseconds from the first processRainBucket() or
+ *          resetRainDay(), 86400000UL for daily.  0 leaves the reset to
+ *          resetRainDay(), e.g. from an RTC alarm at the local midnight
+ */
+#ifndef RAIN_TOTALS_DAY_MS
+#define RAIN_TOTALS_DAY_MS 0
+#endif
+/**
+ * @brief   RAIN_EVENT_DRY_MINUTES - a rain event ends after this many
+ *          minutes without a tip
+ */
+#ifndef RAIN_EVENT_DRY_MINUTES
+#define RAIN_EVENT_DRY_MINUTES 60
+#endif
+
+/**
+ * @brief   WEATHER_ROLLUP - set this to 1 to keep rolling totals of wind
+ *          speed, wind direction and rain over the last seconds, minutes,
+ *          hours and days, e.g. the 2 and 10 minute mean wind or the
+ *          hourly rain.  Each level is a ring of running total snapshots
+ *          taken as its buckets complete, 1 s buckets cascade into 1 min,
+ *          1 h and 1 day buckets, so the total of any number of buckets
+ *          up to the ring size is a single subtraction.  Wind is fed by
+ *          processWindSpeed() (once a second), rain by
+ *          processRainBucket() (once a minute) which starts at minutes.
+ *          Buckets close by the time measured between the calls
+ */
+#ifndef WEATHER_ROLLUP
+#define WEATHER_ROLLUP 0
+#endif
+/**
+ * @brief   WEATHER_ROLLUP_SECONDS - 1 s buckets kept, the longest window
+ *          of the seconds level
+ */
+#ifndef WEATHER_ROLLUP_SECONDS
+#define WEATHER_ROLLUP_SECONDS 120
+#endif
+/**
+ * @brief   WEATHER_ROLLUP_MINUTES - 1 min buckets kept
+ */
+#ifndef WEATHER_ROLLUP_MINUTES
+#define WEATHER_ROLLUP_MINUTES 60
+#endif
+/**
+ * @brief   WEATHER_ROLLUP_HOURS - 1 h buckets kept
+ */
+#ifndef WEATHER_ROLLUP_HOURS
+#define WEATHER_ROLLUP_HOURS 24
+#endif
+/**
+ * @brief   WEATHER_ROLLUP_DAYS - 1 day buckets kept
+ */
+#ifndef WEATHER_ROLLUP_DAYS
+#define WEATHER_ROLLUP_DAYS 7
+#endif
+/**
+ * @brief   WEATHER_ROLLUP_RAM_BYTES - the RAM the rollup rings take, 2
+ *          totals per snapshot for wind speed, 3 for direction and 1
+ *          for rain, which has no seconds level.  Set
+ *          WEATHER_ROLLUP_RAM_LIMIT to fail the build above a budget
+ */
+#define WEATHER_ROLLUP_SLOTS ( ( WEATHER_ROLLUP_SECONDS + 1 ) + ( WEATHER_ROLLUP_MINUTES + 1 ) + \
+                               ( WEATHER_ROLLUP_HOURS + 1 ) + ( WEATHER_ROLLUP_DAYS + 1 ) )
+#define WEATHER_ROLLUP_RAM_BYTES ( 4 * ( 5 * WEATHER_ROLLUP_SLOTS + \
+                                         ( WEATHER_ROLLUP_SLOTS - WEATHER_ROLLUP_SECONDS - 1 ) ) )
+
+#if WEATHER_ROLLUP && ( ( WEATHER_ROLLUP_SECONDS < 1 ) || ( WEATHER_ROLLUP_MINUTES < 1 ) || \
+                        ( WEATHER_ROLLUP_HOURS < 1 ) || ( WEATHER_ROLLUP_DAYS < 1 ) )
+#error "Each WEATHER_ROLLUP level needs at least one bucket"
+#endif
+#if WEATHER_ROLLUP && ( ( WEATHER_ROLLUP_SECONDS > 65534 ) || ( WEATHER_ROLLUP_MINUTES > 65534 ) || \
+                        ( WEATHER_ROLLUP_HOURS > 65534 ) || ( WEATHER_ROLLUP_DAYS > 65534 ) )
+#error "WEATHER_ROLLUP levels hold at most 65534 buckets"
+#endif
+#if WEATHER_ROLLUP && defined( WEATHER_ROLLUP_RAM_LIMIT ) && ( WEATHER_ROLLUP_RAM_BYTES > WEATHER_ROLLUP_RAM_LIMIT )
+#error "The WEATHER_ROLLUP rings don't fit WEATHER_ROLLUP_RAM_LIMIT, reduce the bucket counts"
+#endif
+
+/**
+ * @brief   WEATHER_METER_EVENTS - set this to 1 to have the process
+ *          functions push timestamped events (new vane reading, direction
+ *          change, wind speed sample, rain bucket tips) into queues the
+ *          main loop drains with popWeatherEvent().  There is one wait
+ *          free single producer / single consumer queue per process
+ *          function, so each process function must only be called from
+ *          one context, and events are only read from one context
+ */
+#ifndef WEATHER_METER_EVENTS
+#define WEATHER_METER_EVENTS 0
+#endif
+/**
+ * @brief   WEATHER_METER_EVENT_QUEUE_SIZE - events each queue holds, a
+ *          power of 2.  Events pushed to a full queue are dropped and
+ *          counted
+ */
+#ifndef WEATHER_METER_EVENT_QUEUE_SIZE
+#define WEATHER_METER_EVENT_QUEUE_SIZE 16
+#endif
+
+#if WEATHER_METER_EVENTS && ( WEATHER_METER_EVENT_QUEUE_SIZE & ( WEATHER_METER_EVENT_QUEUE_SIZE - 1 ) )
+#error "WEATHER_METER_EVENT_QUEUE_SIZE must be a power of 2"
+#endif
+
+/**
+ * @brief   WEATHER_METER_PROFILE - set this to 1 to time the process and
+ *          get functions.  Each call is measured with the profile clock,
+ *          the DWT cycle counter on cores that have one, and the count,
+ *          min, max, mean and a log2 histogram of the times are kept per
+ *          function for getWeatherProfile().  Set to 0 it compiles out
+ *          completely
+ */
+#ifndef WEATHER_METER_PROFILE
+#define WEATHER_METER_PROFILE 0
+#endif
+/**
+ * @brief   WEATHER_METER_PROFILE_BINS - histogram bins per function.  Bin
+ *          0 counts calls of 0 or 1 ticks, bin n calls of 2^n up to
+ *          2^(n+1) - 1 ticks and the last bin everything longer
+ */
+#ifndef WEATHER_METER_PROFILE_BINS
+#define WEATHER_METER_PROFILE_BINS 16
+#endif
+
+#if WEATHER_METER_PROFILE && ( ( WEATHER_METER_PROFILE_BINS < 1 ) || ( WEATHER_METER_PROFILE_BINS > 32 ) )
+#error "WEATHER_METER_PROFILE_BINS must be 1 to 32"
+#endif
+
+/**
+ * @brief   WEATHER_METER_HEALTH - set this to 1 to count the signs of the
+ *          pipeline falling behind: wind vane buffers overwritten before
+ *          they were processed, getWindVaneDirection() returning
+ *          WIND_VANE_DIRECTIONS_COUNT, late and missed processWindSpeed()
+ *          and processRainBucket() calls and counter wraps.  Read them
+ *          with getWeatherMeterHealth().  The counters only count up and
+ *          wrap at 2^32, compare two readings to alarm on a rate
+ */
+#ifndef WEATHER_METER_HEALTH
+#define WEATHER_METER_HEALTH 0
+#endif
+/**
+ * @brief   WEATHER_METER_HEALTH_LATE_PERCENT - a process call is late when
+ *          it comes this much after its period
+ */
+#ifndef WEATHER_METER_HEALTH_LATE_PERCENT
+#define WEATHER_METER_HEALTH_LATE_PERCENT 50
+#endif
+/**
+ * @brief   WEATHER_METER_HEALTH_WIND_SPEED_MS / _RAIN_BUCKET_MS - the
+ *          periods processWindSpeed() and processRainBucket() are
+ *          expected to be called at
+ */
+#ifndef WEATHER_METER_HEALTH_WIND_SPEED_MS
+#define WEATHER_METER_HEALTH_WIND_SPEED_MS 1000UL
+#endif
+#ifndef WEATHER_METER_HEALTH_RAIN_BUCKET_MS
+#define WEATHER_METER_HEALTH_RAIN_BUCKET_MS 60000UL
+#endif
+
+/**
+ * @brief   WEATHER_METER_SNAPSHOT - set this to 1 for getStationSnapshot(),
+ *          the direction, wind speed and rain rate of one consistent
+ *          generation of readings.  Each process function publishes its
+ *          readings between two increments of its own sequence counter,
+ *          and the snapshot is retried until no counter was odd or moved
+ *          while it was taken, so the interrupts are never blocked
+ */
+#ifndef WEATHER_METER_SNAPSHOT
+#define WEATHER_METER_SNAPSHOT 0
+#endif
+
+/**
+ * @brief   The type of a single wind vane ADC sample in the DMA buffer
+ */
+#if WIND_VANE_ADC_HALFWORD
+typedef uint16_t windVaneSample_t;
+#else
+typedef uint32_t windVaneSample_t;
+#endif
+
+/**
+ * @brief   An enum to hold the wind vane directions
+ *          WIND_VANE_DIRECTIONS_COUNT will be used as
+ *          both a count of the enum elements as well
+ *          as a general error code
+ */
+typedef enum WIND_VANE_DIRECTIONS
+{
+    N = 0,
+    NNE,
+    NE,
+    ENE,
+    E,
+    ESE,
+    SE,
+    SSE,
+    S,
+    SSW,
+    SW,
+    WSW,
+    W,
+    WNW,
+    NW,
+    NNW,
+    WIND_VANE_DIRECTIONS_COUNT
+} windVaneDir_t;
+
+/**
+ * @brief   The default wind vane ADC values, indexed by windVaneDir_t
+ */
+extern uint32_t WIND_VANE_VALUES[WIND_VANE_DIRECTIONS_COUNT];
+
+/**
+ * @brief   The wind direction averaging windows
+ */
+typedef enum WIND_VANE_WINDOWS
+{
+    WIND_VANE_WINDOW_SHORT = 0,
+    WIND_VANE_WINDOW_LONG
+} windVaneWindow_t;
+
+/**
+ * @brief   A wind gust
+ */
+typedef struct
+{
+    uint32_t count;                     // Anemometer count over the gust
+    uint32_t timestamp;                 // Station ms at the end of the gust
+    windVaneDir_t direction;            // Wind vane direction at the time
+} windGust_t;
+
+/**
+ * @brief   The bucket sizes of the rollup levels
+ */
+typedef enum WEATHER_ROLLUP_LEVELS
+{
+    WEATHER_ROLLUP_LEVEL_SECONDS = 0,
+    WEATHER_ROLLUP_LEVEL_MINUTES,
+    WEATHER_ROLLUP_LEVEL_HOURS,
+    WEATHER_ROLLUP_LEVEL_DAYS,
+    WEATHER_ROLLUP_LEVEL_COUNT
+} weatherRollupLevel_t;
+
+/**
+ * @brief   The kinds of event pushed when WEATHER_METER_EVENTS is 1
+ */
+typedef enum WEATHER_EVENT_TYPES
+{
+    WEATHER_EVENT_VANE_READING = 0,     // value is the new ADC reading
+    WEATHER_EVENT_DIRECTION_CHANGE,     // value is the new windVaneDir_t
+    WEATHER_EVENT_WIND_SPEED,           // value is the anemometer count
+    WEATHER_EVENT_RAIN_TIP,             // value is the number of tips
+    WEATHER_EVENT_RAIN_START,           // value is the tips so far
+    WEATHER_EVENT_RAIN_STOP             // value is the tips of the event
+} weatherEventType_t;
+
+/**
+ * @brief   A timestamped event
+ */
+typedef struct
+{
+    uint32_t timestamp;                 // Station ms the event happened at
+    uint32_t value;                     // Depends on the type
+    weatherEventType_t type;
+} weatherEvent_t;
+
+/**
+ * @brief   The functions timed when WEATHER_METER_PROFILE is 1.  The
+ *          variants of a reading in other units share one entry
+ */
+typedef enum WEATHER_PROFILE_IDS
+{
+    WEATHER_PROFILE_PROCESS_WIND_VANE = 0,      // processWindVane()
+    WEATHER_PROFILE_PROCESS_WIND_VANE_HALF,     // processWindVaneFirstHalf() / SecondHalf()
+    WEATHER_PROFILE_GET_WIND_VANE_DIRECTION,    // getWindVaneDirection()
+    WEATHER_PROFILE_GET_WIND_VANE_DIR_STRING,   // getWindVaneDirString()
+    WEATHER_PROFILE_PROCESS_WIND_SPEED,         // processWindSpeed()
+    WEATHER_PROFILE_GET_WIND_SPEED,             // getWindSpeed_cMPH(), _Q16(), _Unit(), _MPH()
+    WEATHER_PROFILE_RAIN_BUCKET_TIP,            // rainBucketTip()
+    WEATHER_PROFILE_PROCESS_RAIN_BUCKET,        // processRainBucket()
+    WEATHER_PROFILE_GET_RAINFALL,               // getRainfall_milliInPerHr(), _Unit(), _inperhr()
+    WEATHER_PROFILE_COUNT
+} weatherProfileId_t;
+
+/**
+ * @brief   The times of a function, in ticks of the profile clock
+ */
+typedef struct
+{
+    uint32_t count;                     // Calls timed
+    uint32_t min;                       // Shortest call, 0 before any
+    uint32_t max;                       // Longest call
+    uint32_t mean;                      // Mean call
+    uint64_t total;                     // All calls together
+    uint32_t hz;                        // Rate of the profile clock
+    uint32_t histogram[WEATHER_METER_PROFILE_BINS];
+} weatherProfile_t;
+
+/**
+ * @brief   The health counters kept when WEATHER_METER_HEALTH is 1
+ */
+typedef struct
+{
+    uint32_t vaneOverruns;              // Wind vane buffers overwritten before processing
+    uint32_t vaneOutOfBand;             // Wind vane buffers in no direction's band
+    uint32_t windSpeedLate;             // processWindSpeed() calls late
+    uint32_t windSpeedMissed;           // Periods without a processWindSpeed() call
+    uint32_t rainBucketLate;            // processRainBucket() calls late
+    uint32_t rainBucketMissed;          // Periods without a processRainBucket() call
+    uint32_t windSpeedWraps;            // Anemometer counter wraps losing pulses, or capture ring laps
+    uint32_t rainBucketWraps;           // Rain bucket counter wraps losing pulses
+} weatherMeterHealth_t;
+
+/**
+ * @brief   The readings of a station at one time, WEATHER_METER_SNAPSHOT
+ */
+typedef struct
+{
+    uint32_t generation;                // Readings published so far
+    windVaneDir_t direction;            // Of the average, as getWindVaneDirection()
+    uint32_t average;                   // Wind vane ADC code
+    uint32_t windSpeed_cMPH;            // As getWindSpeed_cMPH()
+    uint32_t rainfall_milliInPerHr;     // As getRainfall_milliInPerHr()
+    uint32_t windVaneTime;              // Station ms of the wind vane reading
+    uint32_t windSpeedTime;             // Station ms of the wind speed reading
+    uint32_t rainTime;                  // Station ms of the rain reading, the last tip with RAIN_BUCKET_TIPS
+} stationSnapshot_t;
+
+/**
+ * @brief   The rain totals kept when RAIN_TOTALS is 1, all in tips
+ */
+typedef struct
+{
+    uint64_t total;                     // Since start
+    uint32_t lastHour;                  // The last 60 minutes
+    uint32_t last24h;                   // The last 24 hours, in 15 minute steps
+    uint32_t today;                     // Since the day was reset
+    uint32_t eventTips;                 // The current or last rain event
+    uint32_t eventStart;                // Station ms at its start
+    uint32_t eventEnd;                  // Station ms at its last tips
+    uint8_t raining;                    // 1 while the event goes on
+} rainTotals_t;
+
+/**
+ * @brief   The state of one weather station.  Declare one per station,
+ *          e.g. a static, and start it with initWeatherMeter() or
+ *          WEATHER_METER_INIT.  The members are private, use the wm
+ *          functions
+ */
+typedef struct weatherMeter_s weatherMeter_t;
+
+/**
+ * @brief   Called with the station and the day's tips when the day is
+ *          reset
+ */
+typedef void (*rainDayHook_t)( weatherMeter_t *wm, uint32_t tips );
+
+/**
+ * @brief   A clock the process functions time their intervals with
+ */
+typedef uint32_t (*weatherMeterClock_t)( void );
+
+#ifndef __ALIGNED
+#define __ALIGNED( x ) __attribute__( ( aligned( x ) ) )
+#endif
+
+#if WIND_VANE_ESTIMATOR != WIND_VANE_ESTIMATOR_MEAN
+/**
+ * @brief   WIND_VANE_COARSE_BINS - first pass histogram bins, the top 6
+ *          bits of the code
+ */
+#define WIND_VANE_COARSE_BINS 64
+/**
+ * @brief   WIND_VANE_FINE_BITS - the bits of the code below the coarse
+ *          bin, resolved by the second pass
+ */
+#define WIND_VANE_FINE_BITS ( WIND_VANE_ADC_BITS - 6 )
+#define WIND_VANE_FINE_BINS ( 1UL << WIND_VANE_FINE_BITS )
+
+/**
+ * @brief   Histograms for the rank estimators, in the station so they
+ *          stay off the ISR stack and stations can reduce at once
+ */
+typedef struct
+{
+    uint16_t coarseCount[WIND_VANE_COARSE_BINS];
+    uint32_t coarseSum[WIND_VANE_COARSE_BINS];
+    // Second pass.  Row 1 is the bin holding the lowest rank wanted, row
+    // 2 the bin holding the highest, row 3 the bin holding both and row
+    // 0 collects everything else
+    uint16_t fineCount[4][WIND_VANE_FINE_BINS];
+} windVaneRank_t;
+#endif /* WIND_VANE_ESTIMATOR */
+
+#if WIND_VANE_AUTOCAL
+/**
+ * @brief   WIND_VANE_AUTOCAL_BINS - the number of histogram bins
+ */
+#define WIND_VANE_AUTOCAL_BINS ( ( 1UL << WIND_VANE_ADC_BITS ) >> WIND_VANE_AUTOCAL_BIN_SHIFT )
+
+/**
+ * @brief   Self calibration state
+ */
+typedef struct
+{
+    uint16_t hist[WIND_VANE_AUTOCAL_BINS];              // Recent averages
+    uint32_t centers[WIND_VANE_DIRECTIONS_COUNT];       // Values being adjusted
+    uint32_t seed[WIND_VANE_DIRECTIONS_COUNT];          // Values started from
+    uint32_t tables[2][WIND_VANE_DIRECTIONS_COUNT];     // Published values
+    uint32_t decayBin;                                  // Next bin to age
+    uint32_t count;                                     // Buffers since a swap
+    uint8_t next;                                       // Table to publish to
+#if WIND_VANE_USE_LUT
+    uint32_t lutCode;                                   // Next code to rebuild
+#endif
+} windVaneAutoCal_t;
+#endif /* WIND_VANE_AUTOCAL */
+
+#if WIND_VANE_DEBOUNCE
+/**
+ * @brief   Debouncing state
+ */
+typedef struct
+{
+    volatile uint32_t changes;      // Committed changes, wraps
+    volatile uint8_t committed;     // Debounced direction
+    uint8_t candidate;              // Direction waiting to be committed
+    uint32_t count;                 // Consecutive readings of the candidate
+    uint32_t since;                 // Tick the candidate was first read
+    uint32_t seen;                  // changes at the last getWindVaneDirChanged()
+} windVaneDebounce_t;
+#endif /* WIND_VANE_DEBOUNCE */
+
+#if WIND_VANE_VECTOR_AVG
+/**
+ * @brief   A block of unit vectors in the averaging windows
+ */
+typedef struct
+{
+    int32_t east;                   // Sum of the sines
+    int32_t north;                  // Sum of the cosines
+    uint16_t count;                 // Valid readings in the block
+} windVaneVectorBlock_t;
+
+/**
+ * @brief   Vector averaging state
+ */
+typedef struct
+{
+    windVaneVectorBlock_t blocks[WIND_VANE_VECTOR_LONG_BLOCKS];
+    windVaneVectorBlock_t windows[2];   // Running sums, by windVaneWindow_t
+    uint32_t head;                      // Block being filled
+    uint32_t buffers;                   // Buffers in the block being filled
+    volatile uint32_t updates;          // Bumped around each update
+} windVaneVector_t;
+#endif /* WIND_VANE_VECTOR_AVG */
+
+#if WIND_GUST
+/**
+ * @brief   A gust in the peak queue
+ */
+typedef struct
+{
+    uint32_t timestamp;
+    uint16_t count;
+    uint8_t direction;
+} windGustEntry_t;
+
+/**
+ * @brief   Gust tracking state
+ */
+typedef struct
+{
+    uint16_t samples[WIND_GUST_SAMPLES];        // The last samples
+    uint32_t intervals[WIND_GUST_SAMPLES];      // Their milliseconds
+    uint32_t sampleIdx;                         // Oldest sample
+    uint32_t sum;                               // Sum of the samples
+    uint32_t sumMs;                             // Sum of their milliseconds
+    volatile uint32_t gust;                     // Count over WIND_GUST_SAMPLES seconds
+    windGustEntry_t queue[WIND_GUST_QUEUE_SIZE];// Decreasing gusts, oldest first
+    uint32_t head;                              // Oldest gust in the queue
+    uint32_t len;                               // Gusts in the queue
+    volatile uint32_t updates;                  // Bumped around each update
+} windGustState_t;
+#endif /* WIND_GUST */
+
+#if RAIN_BUCKET_TIPS
+/**
+ * @brief   The times of the last rain bucket tips.  The tip interrupt is
+ *          the only writer, it writes a time and then publishes it by
+ *          bumping the count
+ */
+typedef struct
+{
+    uint32_t times[RAIN_BUCKET_TIPS_RING];      // Station ms of each tip
+    volatile uint32_t count;                    // Tips so far, indexes the ring
+    uint32_t seen;                              // count at the last processRainBucket()
+} rainBucketTips_t;
+#endif /* RAIN_BUCKET_TIPS */
+
+#if RAIN_TOTALS
+/**
+ * @brief   Rain accumulation state.  The rolling sums include the open
+ *          bucket of their ring and drop a bucket as it's reused, so a
+ *          query never walks a ring
+ */
+typedef struct
+{
+    uint16_t minutes[60];                       // Tips of each minute
+    uint16_t quarters[96];                      // Tips of each 15 minutes
+    uint32_t minuteIdx;                         // The open minute
+    uint32_t quarterIdx;                        // The open quarter hour
+    uint32_t quarterPhase;                      // Minutes into the quarter hour
+    uint32_t pendingMs;                         // Time into the open minute
+    uint32_t hourSum;                           // Sum of minutes[]
+    uint32_t daySum;                            // Sum of quarters[]
+    uint64_t total;                             // Tips since start
+    uint32_t today;                             // Tips since the day reset
+#if RAIN_TOTALS_DAY_MS
+    uint32_t dayMs;                             // Time into the day
+#endif
+    uint32_t eventTips;                         // Tips of the rain event
+    uint32_t eventStart;                        // Station ms it started at
+    uint32_t eventEnd;                          // Station ms of its last tips
+    uint32_t dryMs;                             // Time since then
+    uint8_t raining;                            // 1 while it's going on
+    volatile uint32_t updates;                  // Bumped around each update
+    rainDayHook_t hook;                         // Called when the day closes
+} rainTotalsState_t;
+#endif /* RAIN_TOTALS */
+
+#if WEATHER_METER_EVENTS
+/**
+ * @brief   The event queues, one per producer
+ */
+typedef enum WEATHER_EVENT_QUEUES
+{
+    WEATHER_EVENT_QUEUE_VANE = 0,
+    WEATHER_EVENT_QUEUE_SPEED,
+    WEATHER_EVENT_QUEUE_RAIN,
+#if RAIN_TOTALS
+    WEATHER_EVENT_QUEUE_RAIN_EVENTS,
+#endif
+    WEATHER_EVENT_QUEUE_COUNT
+} weatherEventQueueId_t;
+
 /**
- * @brief   WIND_VANE_CODE_BAND - this value will set the window size
- *          when measuring the ADC.  Adjust this value to compensate
- *          for noise in the system
+ * @brief   A single producer / single consumer event queue.  The producer
+ *          only writes head, the consumer only writes tail, both count
+ *          up freely and are masked to index the ring
  */
-#define WIND_VANE_CODE_BAND  20
+typedef struct
+{
+    weatherEvent_t ring[WEATHER_METER_EVENT_QUEUE_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t drops;
+} weatherEventQueue_t;
+#endif /* WEATHER_METER_EVENTS */
 
+#if WEATHER_ROLLUP
 /**
- * @brief   An enum to hold the wind vane directions
- *          WIND_VANE_DIRECTIONS_COUNT will be used as
- *          both a count of the enum elements as well
- *          as a general error code
+ * @brief   A channel of the rollup.  The running totals only ever count
+ *          up, modulo 2^32, and each level keeps the totals as they were
+ *          at its last bucket boundaries, so the difference of two
+ *          snapshots is the total of the buckets between them
  */
-typedef enum WIND_VANE_DIRECTIONS
+typedef struct
 {
-    N = 0,
-    NNE,
-    NE,
-    ENE,
-    E,
-    ESE,
-    SE,
-    SSE,
-    S,
-    SSW,
-    SW,
-    WSW,
-    W,
-    WNW,
-    NW,
-    NNW,
-    WIND_VANE_DIRECTIONS_COUNT
-} windVaneDir_t;
+    uint32_t *ring;                             // Snapshots, base level first
+    uint8_t qty;                                // Totals per snapshot
+    uint8_t base;                               // The first level kept
+    uint32_t total[3];                          // The running totals
+    uint16_t head[WEATHER_ROLLUP_LEVEL_COUNT];  // Newest snapshot of each level
+    uint16_t filled[WEATHER_ROLLUP_LEVEL_COUNT];// Completed buckets, up to the size
+    uint8_t phase[WEATHER_ROLLUP_LEVEL_COUNT];  // Lower buckets into the current one
+    uint32_t pendingMs;                         // Time into the current base bucket
+    volatile uint32_t updates;                  // Bumped around each update
+} weatherRollup_t;
+#endif /* WEATHER_ROLLUP */
+
+#if WEATHER_METER_HEALTH
+/**
+ * @brief   The health counters and what they are worked out from.  Each
+ *          counter is only written from the context of the function
+ *          counting it
+ */
+typedef struct
+{
+    weatherMeterHealth_t counts;
+    volatile uint32_t vaneDone;         // Buffers the DMA completed, from windVaneBufferDone()
+    uint32_t vaneSeen;                  // vaneDone at the last processing
+    uint8_t vaneLastHalf;               // Last half processed, 1 or 2, 0 before any
+} weatherMeterHealthState_t;
+#endif /* WEATHER_METER_HEALTH */
+
+#if WEATHER_METER_SNAPSHOT
+/**
+ * @brief   The sequence counters of the readings, one per writer so a
+ *          writer never has to wait for another, and the times of the
+ *          readings
+ */
+typedef struct
+{
+    volatile uint32_t vaneSeq;          // Odd while the wind vane reading is written
+    volatile uint32_t speedSeq;         // Odd while the wind speed reading is written
+    volatile uint32_t rainSeq;          // Odd while the rain reading is written
+#if RAIN_BUCKET_TIPS
+    volatile uint32_t tipSeq;           // Odd while a tip is written
+#endif
+    volatile uint32_t vaneTime;         // Station ms of the wind vane reading
+    volatile uint32_t speedTime;        // Station ms of the wind speed reading
+    volatile uint32_t rainTime;         // Station ms of the rain reading
+} weatherSnapshotState_t;
+#endif /* WEATHER_METER_SNAPSHOT */
+
+/**
+ * @brief   The state of one weather station.  What every process call
+ *          reads and writes comes first so it shares a cache line or two,
+ *          which keeps iterating over many stations cheap.  The DMA
+ *          buffers and rings come last
+ */
+struct weatherMeter_s
+{
+    volatile uint32_t average;                  // Last wind vane reading
+    const uint32_t * volatile windVaneValues;   // Values table in use
+#if WIND_VANE_USE_LUT
+    const uint8_t * volatile windVaneLut;       // Lookup table in use
+#endif
+#if WIND_VANE_VOTE
+    volatile uint32_t vote;                     // Direction and share of the last vote
+#endif
+#if WEATHER_METER_EVENTS && !WIND_VANE_DEBOUNCE
+    uint8_t lastDir;                            // Last direction change pushed
+#endif
+    volatile uint32_t windSpeedCount;           // Anemometer count of the last call
+    volatile uint32_t windSpeedInterval;        // Milliseconds it was counted over
+    uint32_t windSpeedLastTime;                 // Clock at the last call
+#if WEATHER_METER_FREE_RUNNING && !WIND_SPEED_CAPTURE
+    uint32_t windSpeedLastCnt;                  // Counter at the last call
+#endif
+    volatile uint32_t rainBucketCount;          // Rain bucket tips of the last call
+    volatile uint32_t rainBucketInterval;       // Milliseconds they were counted over
+    uint32_t rainBucketLastTime;                // Clock at the last call
+#if WEATHER_METER_FREE_RUNNING && !RAIN_BUCKET_TIPS
+    uint32_t rainBucketLastCnt;                 // Counter at the last call
+#endif
+    weatherMeterClock_t clock;                  // Interval clock
+    uint32_t clockHz;                           // And its rate
+    ADC_HandleTypeDef *windVaneAdc;             // ADC reading the wind vane
+    TIM_HandleTypeDef *windSpeedTimer;          // Timer counting the anemometer
+#if !RAIN_BUCKET_TIPS
+    TIM_HandleTypeDef *rainBucketCounter;       // Timer counting the rain bucket
+#endif
+#if WIND_SPEED_CAPTURE
+    DMA_HandleTypeDef *captureDma;              // DMA filling the capture ring
+    uint32_t captureRead;                       // Next entry of the ring to read
+    uint32_t captureLastTick;                   // Station ms of the last pulse
+    volatile uint32_t windSpeedPeriodQ8;        // Pulse period in 1/256 timer ticks, 0 is calm
+    uint16_t captureLast;                       // Timestamp of the last pulse
+    uint8_t captureValid;                       // Set when captureLast can start a period
+    uint8_t captureHeld;                        // Set when captureLast is in the ring behind captureRead
+#endif
+#if WIND_VANE_DEBOUNCE
+    windVaneDebounce_t debounce;
+#endif
+#if RAIN_BUCKET_TIPS
+    rainBucketTips_t rainTips;
+#endif
+#if WIND_VANE_VECTOR_AVG
+    windVaneVector_t vector;
+#endif
+#if WIND_GUST
+    windGustState_t gust;
+#endif
+#if RAIN_TOTALS
+    rainTotalsState_t rainTotals;
+#endif
+#if WEATHER_ROLLUP
+    weatherRollup_t rollupSpeed;                // Anemometer count and milliseconds
+    weatherRollup_t rollupDir;                  // East and north Q8 sums and samples
+    weatherRollup_t rollupRain;                 // Tips, from the minutes level
+#endif
+#if WEATHER_METER_EVENTS
+    weatherEventQueue_t eventQueues[WEATHER_EVENT_QUEUE_COUNT];
+#endif
+#if WIND_VANE_AUTOCAL
+    windVaneAutoCal_t autoCal;
+#endif
+#if WEATHER_METER_HEALTH
+    weatherMeterHealthState_t health;
+#endif
+#if WEATHER_METER_SNAPSHOT
+    weatherSnapshotState_t snapshot;
+#endif
+    // Word aligned so halfword samples can be read two at a time
+    windVaneSample_t adcBuf[WIND_VANE_ADC_BUF_SIZE] __ALIGNED( 4 );
+#if WIND_SPEED_CAPTURE
+    uint16_t captureBuf[WIND_SPEED_CAPTURE_BUF_SIZE];
+#endif
+#if WIND_VANE_ESTIMATOR != WIND_VANE_ESTIMATOR_MEAN
+    windVaneRank_t rank;
+#endif
+#if WIND_VANE_USE_LUT && !WIND_VANE_EXTERNAL_TABLES
+    // Two directions per byte, the even code in the low nibble
+    uint8_t windVaneLutBuf[WIND_VANE_LUT_SIZE];
+#endif
+#if WEATHER_ROLLUP
+    uint32_t rollupSpeedRing[WEATHER_ROLLUP_SLOTS * 2];
+    uint32_t rollupDirRing[WEATHER_ROLLUP_SLOTS * 3];
+    uint32_t rollupRainRing[WEATHER_ROLLUP_SLOTS - WEATHER_ROLLUP_SECONDS - 1];
+#endif
+};
+
+#if WIND_VANE_USE_LUT && !WIND_VANE_EXTERNAL_TABLES
+#define WEATHER_METER_INIT_LUT( name )      .windVaneLut = ( name ).windVaneLutBuf,
+#else
+#define WEATHER_METER_INIT_LUT( name )
+#endif
+#if WIND_VANE_VOTE
+#define WEATHER_METER_INIT_VOTE             .vote = WIND_VANE_DIRECTIONS_COUNT,
+#else
+#define WEATHER_METER_INIT_VOTE
+#endif
+#if WEATHER_METER_EVENTS && !WIND_VANE_DEBOUNCE
+#define WEATHER_METER_INIT_LAST_DIR         .lastDir = WIND_VANE_DIRECTIONS_COUNT,
+#else
+#define WEATHER_METER_INIT_LAST_DIR
+#endif
+#if WIND_VANE_DEBOUNCE
+#define WEATHER_METER_INIT_DEBOUNCE         .debounce = { .committed = WIND_VANE_DIRECTIONS_COUNT, \
+                                                          .candidate = WIND_VANE_DIRECTIONS_COUNT },
+#else
+#define WEATHER_METER_INIT_DEBOUNCE
+#endif
+#if WEATHER_ROLLUP
+#define WEATHER_METER_INIT_ROLLUP( name )   .rollupSpeed = { .ring = ( name ).rollupSpeedRing, .qty = 2, \
+                                                             .base = WEATHER_ROLLUP_LEVEL_SECONDS }, \
+                                            .rollupDir = { .ring = ( name ).rollupDirRing, .qty = 3, \
+                                                           .base = WEATHER_ROLLUP_LEVEL_SECONDS }, \
+                                            .rollupRain = { .ring = ( name ).rollupRainRing, .qty = 1, \
+                                                            .base = WEATHER_ROLLUP_LEVEL_MINUTES },
+#else
+#define WEATHER_METER_INIT_ROLLUP( name )
+#endif
+/**
+ * @brief   WEATHER_METER_INIT - a static initializer for a station, the
+ *          same state initWeatherMeter() sets up, e.g.
+ *              static weatherMeter_t station = WEATHER_METER_INIT( station );
+ *          C only, C++ code should call initWeatherMeter()
+ */
+#define WEATHER_METER_INIT( name )  { .windVaneValues = WIND_VANE_VALUES,     \
+                                      WEATHER_METER_INIT_LUT( name )          \
+                                      WEATHER_METER_INIT_VOTE                 \
+                                      WEATHER_METER_INIT_LAST_DIR             \
+                                      .windSpeedInterval = 1000,              \
+                                      .rainBucketInterval = 60000,            \
+                                      .clock = HAL_GetTick,                   \
+                                      .clockHz = 1000,                        \
+                                      WEATHER_METER_INIT_DEBOUNCE             \
+                                      WEATHER_METER_INIT_ROLLUP( name ) }
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief   Sets up a station, before any other function is called on it.
+ *          The functions without a station argument all work on a
+ *          default station, returned by getWeatherMeter(), the wm
+ *          functions at the end of this file take the station to work on
+ * @param   wm - The station, storage provided by the caller
+ * @retval  0 on success, 1 on failure
+ */
+int8_t initWeatherMeter( weatherMeter_t *wm );
+/**
+ * @brief   Returns the default station the functions without a station
+ *          argument work on
+ * @param   None
+ * @retval  The default station
+ */
+weatherMeter_t* getWeatherMeter( void );
+
+/**
+ * @brief   Sets the clock the process functions time the interval since
+ *          their previous call with, HAL_GetTick() at 1000 Hz by default.
+ *          The rates come from the measured interval, so the process
+ *          functions can be called late, early or batched.  A faster
+ *          clock like the DWT cycle counter gives finer intervals, the
+ *          process functions must then be called at least once per wrap
+ *          of it.  Timestamps, debounce dwells, gust windows and timeouts
+ *          are in station milliseconds: the clock itself when hz is 1000,
+ *          so a test clock drives everything, and HAL_GetTick() for a
+ *          faster clock, which wraps too soon to time minutes and hours
+ * @param   clock - The clock, counting up and wrapping at 2^32
+ * @param   hz - The clock rate
+ * @retval  0 on success, 1 on failure
+ */
+int8_t setWeatherMeterClock( weatherMeterClock_t clock, uint32_t hz );
+
 /**
  * @brief   Wind vane initialization function
  * @param   hadc - A pointer to the handle of the ADC that will
@@ -92,6 +1356,24 @@ int8_t initWindVane( ADC_HandleTypeDef* hadc );
  * @retval  None
  */
 void processWindVane( void );
+#if WIND_VANE_DOUBLE_BUFFER
+/**
+ * @brief   Averages the first half of the ADC buffer.  Call this from
+ *          the DMA half transfer complete callback, while the DMA is
+ *          filling the second half.
+ * @param   None
+ * @retval  None
+ */
+void processWindVaneFirstHalf( void );
+/**
+ * @brief   Averages the second half of the ADC buffer.  Call this from
+ *          the DMA transfer complete callback, while the DMA is
+ *          filling the first half.
+ * @param   None
+ * @retval  None
+ */
+void processWindVaneSecondHalf( void );
+#endif /* WIND_VANE_DOUBLE_BUFFER */
 /**
  * @brief   Searches the values table and returns the current direction
  *          matching the most recent ADC average value
@@ -99,6 +1381,96 @@ void processWindVane( void );
  * @retval  The current wind vane direction.
  */
 windVaneDir_t getWindVaneDirection( void );
+/**
+ * @brief   Installs the tables used to classify the wind vane readings,
+ *          e.g. ones generated at compile time and kept in flash.
+ *          The tables are not copied and must stay valid.
+ * @param   values - The ADC value of each direction, indexed by
+ *          windVaneDir_t
+ * @param   lut - The lookup table matching values, in the format built
+ *          by buildWindVaneLut().  If NULL the library builds one from
+ *          values.  Ignored when WIND_VANE_USE_LUT is 0
+ * @retval  0 on success, 1 on failure
+ */
+int8_t setWindVaneTables( const uint32_t *values, const uint8_t *lut );
+#if WIND_VANE_USE_LUT && !WIND_VANE_EXTERNAL_TABLES
+/**
+ * @brief   Rebuilds the direction lookup table from the values table.
+ *          initWindVane() calls this, call it again if the values table
+ *          is changed afterwards.  Scans the values table once per ADC
+ *          code so it should not be called from an ISR.
+ * @param   None
+ * @retval  None
+ */
+void buildWindVaneLut( void );
+#endif /* WIND_VANE_USE_LUT && !WIND_VANE_EXTERNAL_TABLES */
+#if WIND_VANE_DEBOUNCE
+/**
+ * @brief   Returns the debounced wind vane direction
+ * @param   None
+ * @retval  The debounced direction, WIND_VANE_DIRECTIONS_COUNT until the
+ *          first valid reading
+ */
+windVaneDir_t getWindVaneDirectionDebounced( void );
+/**
+ * @brief   Returns the number of debounced direction changes so far.
+ *          Wraps around, compare it with a previous value to see if the
+ *          direction changed.
+ * @param   None
+ * @retval  The number of changes
+ */
+uint32_t getWindVaneDirChangeCount( void );
+/**
+ * @brief   Checks for a debounced direction change since the last call.
+ *          Meant for a single consumer, others should use
+ *          getWindVaneDirChangeCount()
+ * @param   None
+ * @retval  1 if the direction changed, 0 otherwise
+ */
+uint8_t getWindVaneDirChanged( void );
+#endif /* WIND_VANE_DEBOUNCE */
+#if WIND_VANE_VOTE
+/**
+ * @brief   Returns the direction most samples of the last processed
+ *          buffer were classified as
+ * @param   share - A pointer to store the percentage of the samples that
+ *          voted for it, 0 when no sample was in a band.  May be NULL
+ * @retval  The winning direction, WIND_VANE_DIRECTIONS_COUNT if no sample
+ *          was in a band
+ */
+windVaneDir_t getWindVaneVoteDirection( uint8_t *share );
+#endif /* WIND_VANE_VOTE */
+#if WIND_VANE_VECTOR_AVG
+/**
+ * @brief   Returns the vector averaged wind direction over a window
+ * @param   window - The window to average over
+ * @param   direction - A pointer to store the mean direction, in tenths
+ *          of a degree clockwise from N (0 - 3599)
+ * @param   steadiness - A pointer to store the length of the mean unit
+ *          vector in thousandths.  1000 means the direction never
+ *          changed, close to 0 means there's no prevailing direction.
+ *          May be NULL
+ * @retval  0 on success, 1 if there are no valid readings in the window
+ */
+int8_t getWindVaneMeanDirection( windVaneWindow_t window, uint16_t *direction,
+                                 uint16_t *steadiness );
+#endif /* WIND_VANE_VECTOR_AVG */
+/**
+ * @brief   Returns the values table currently used to classify the wind
+ *          vane readings, e.g. to store the result of self calibration
+ * @param   None
+ * @retval  The ADC value of each direction, indexed by windVaneDir_t
+ */
+const uint32_t* getWindVaneValues( void );
+#if WIND_VANE_AUTOCAL
+/**
+ * @brief   Restarts self calibration from the values table currently in
+ *          use.  initWindVane() and setWindVaneTables() call this.
+ * @param   None
+ * @retval  None
+ */
+void resetWindVaneAutoCal( void );
+#endif /* WIND_VANE_AUTOCAL */
 /**
  * @brief   Retrieves the string matching the direction given.
  * @param   direction - The direction to retreive the string for.
@@ -108,6 +1480,23 @@ windVaneDir_t getWindVaneDirection( void );
  */
 void getWindVaneDirString( windVaneDir_t direction, uint8_t *string );
 
+#if WIND_SPEED_CAPTURE
+/**
+ * @brief   Wind speed initialization function for input capture
+ * @param   htim - A pointer to the handle for the Timer that will be
+ *          capturing the anemometer pulses
+ * @param   channel - The capture channel, TIM_CHANNEL_1 to TIM_CHANNEL_4
+ * @retval  0 on success, 1, on failure
+ */
+int8_t initWindSpeedCapture( TIM_HandleTypeDef *htim, uint32_t channel );
+/**
+ * @brief   Returns the period of the anemometer pulses
+ * @param   None
+ * @retval  The period in ticks of WIND_SPEED_CAPTURE_TICK_HZ, 0 when the
+ *          wind is calm
+ */
+uint32_t getWindSpeedPeriod( void );
+#else
 /**
  * @brief   Wind speed initialization function
  * @param   htim - A pointer to the handle for the Timer that will be
@@ -115,25 +1504,126 @@ void getWindVaneDirString( windVaneDir_t direction, uint8_t *string );
  * @retval  0 on success, 1, on failure
  */
 int8_t initWindSpeed( TIM_HandleTypeDef *htim );
+#endif /* WIND_SPEED_CAPTURE */
 /**
- * @brief   Call this function to read the counter and
- *          update the variable
+ * @brief   Call this function, nominally once a second, to read the
+ *          counter and update the variable.  The speed is the count over
+ *          the measured time since the previous call.  With
+ *          WIND_SPEED_CAPTURE it takes the new pulses
  * @param   None
  * @retval  None
  */
 void processWindSpeed( void );
 /**
- * @brief   Returns the raw count of the wind speed sensor
+ * @brief   Returns the raw count of the wind speed sensor, with
+ *          WIND_SPEED_CAPTURE the pulses taken by the last
+ *          processWindSpeed()
  * @param   None
  * @retval  The raw count of the wind speed sensor
  */
 uint32_t getWindSpeedCount( void );
+/**
+ * @brief   Converts the raw count to hundredths of a MPH
+ * @param   None
+ * @retval  The average wind speed in hundredths of a MPH
+ */
+uint32_t getWindSpeed_cMPH( void );
+/**
+ * @brief   Converts the raw count to MPH in Q16.16 fixed point
+ * @param   None
+ * @retval  The average wind speed in 1/65536 of a MPH
+ */
+uint32_t getWindSpeed_Q16( void );
+/**
+ * @brief   Converts the raw count to WIND_SPEED_UNIT
+ * @param   None
+ * @retval  The average wind speed in hundredths of WIND_SPEED_UNIT, or
+ *          the Beaufort force
+ */
+uint32_t getWindSpeed_Unit( void );
+#if WEATHER_METER_USE_DOUBLE
 /**
  * @brief   Convience function to convert raw count to MPH
  * @param   None
  * @retval  A double that indicates the average wind speed in MPH
  */
 double getWindSpeed_MPH( void );
+#endif
+#if WIND_GUST
+/**
+ * @brief   Returns the current gust, the average of the last
+ *          WIND_GUST_SAMPLES samples
+ * @param   None
+ * @retval  The gust speed in hundredths of a MPH
+ */
+uint32_t getWindGust_cMPH( void );
+/**
+ * @brief   Returns the highest gust of the last WIND_GUST_PEAK_MS
+ * @param   gust - A pointer to store the gust
+ * @retval  0 on success, 1 if there are no samples yet
+ */
+int8_t getWindGustPeak( windGust_t *gust );
+/**
+ * @brief   Returns the speed of the highest gust of the last
+ *          WIND_GUST_PEAK_MS
+ * @param   None
+ * @retval  The peak gust speed in hundredths of a MPH
+ */
+uint32_t getWindGustPeak_cMPH( void );
+/**
+ * @brief   Returns the current gust in WIND_SPEED_UNIT
+ * @param   None
+ * @retval  The gust speed in hundredths of WIND_SPEED_UNIT, or the
+ *          Beaufort force
+ */
+uint32_t getWindGust_Unit( void );
+/**
+ * @brief   Returns the speed of the highest gust of the last
+ *          WIND_GUST_PEAK_MS in WIND_SPEED_UNIT
+ * @param   None
+ * @retval  The peak gust speed in hundredths of WIND_SPEED_UNIT, or the
+ *          Beaufort force
+ */
+uint32_t getWindGustPeak_Unit( void );
+#if WEATHER_METER_USE_DOUBLE
+/**
+ * @brief   Returns the current gust, the average of the last
+ *          WIND_GUST_SAMPLES samples
+ * @param   None
+ * @retval  The gust speed in MPH
+ */
+double getWindGust_MPH( void );
+/**
+ * @brief   Returns the speed of the highest gust of the last
+ *          WIND_GUST_PEAK_MS
+ * @param   None
+ * @retval  The peak gust speed in MPH
+ */
+double getWindGustPeak_MPH( void );
+#endif /* WEATHER_METER_USE_DOUBLE */
+#endif /* WIND_GUST */
+#if RAIN_BUCKET_TIPS
+/**
+ * @brief   Rain bucket initialization function, when the tips come from
+ *          an interrupt
+ * @param   None
+ * @retval  0 on success
+ */
+int8_t initRainBucketTips( void );
+/**
+ * @brief   Call this function from the interrupt of the rain bucket pin
+ *          on every tip
+ * @param   None
+ * @retval  None
+ */
+void rainBucketTip( void );
+/**
+ * @brief   Returns the tips counted so far
+ * @param   None
+ * @retval  The tips, wrapping at 2^32
+ */
+uint32_t getRainBucketTips( void );
+#else
 /**
  * @brief   Rain bucket initialization function
  * @param   htim - A pointer to the handle for the Timer that will be
@@ -141,19 +1631,358 @@ double getWindSpeed_MPH( void );
  * @retval  0 on success, 1, on failure
  */
 int8_t initRainBucket( TIM_HandleTypeDef *htim );
+#endif /* RAIN_BUCKET_TIPS */
 /**
- * @brief   Call this function once a minute to read the counter and
- *          update the variable
+ * @brief   Call this function, nominally once a minute, to read the
+ *          counter and update the variable.  The rate is the count over
+ *          the measured time since the previous call
  * @param   None
  * @retval  None
  */
 void processRainBucket( void );
+/**
+ * @brief   Returns the converted count in thousandths of an inch per hour.
+ *          With RAIN_BUCKET_TIPS it's the rate between the last tips
+ * @param   None
+ * @retval  Average rainfall in thousandths of an inch per hour
+ */
+uint32_t getRainfall_milliInPerHr( void );
+/**
+ * @brief   Returns the converted count in RAIN_UNIT per hour
+ * @param   None
+ * @retval  Average rainfall in thousandths of RAIN_UNIT per hour
+ */
+uint32_t getRainfall_Unit( void );
+#if WEATHER_METER_USE_DOUBLE
 /**
  * @brief   Returns the converted count in inches per hour
  * @param   None
  * @retval  Average rainfall in inches per hour
  */
 double getRainfall_inperhr( void );
+#endif
+
+#if RAIN_TOTALS
+/**
+ * @brief   Returns the rain totals, call processRainBucket() to update
+ *          them
+ * @param   totals - A pointer to store the totals
+ * @retval  0 on success, 1 on failure
+ */
+int8_t getRainTotals( rainTotals_t *totals );
+/**
+ * @brief   Starts a new day, from the same context as processRainBucket()
+ * @param   None
+ * @retval  None
+ */
+void resetRainDay( void );
+/**
+ * @brief   Sets the function called with the day's tips when the day is
+ *          reset, by resetRainDay() or RAIN_TOTALS_DAY_MS.  It's called
+ *          from processRainBucket() or resetRainDay()
+ * @param   hook - The function, NULL for none
+ * @retval  None
+ */
+void setRainDayHook( rainDayHook_t hook );
+#endif /* RAIN_TOTALS */
+
+#if WEATHER_ROLLUP
+/**
+ * @brief   Returns the anemometer total over the last completed buckets
+ *          of a rollup level, e.g. 120 seconds or 10 minutes
+ * @param   level - The bucket size
+ * @param   buckets - The buckets to cover, at most the level's ring size.
+ *          Fewer are covered until that many have completed
+ * @param   count - A pointer to store the anemometer count
+ * @param   ms - A pointer to store the milliseconds the count was
+ *          taken over.  May be NULL
+ * @retval  0 on success, 1 on failure or if no bucket completed yet
+ */
+int8_t getWindSpeedRollup( weatherRollupLevel_t level, uint16_t buckets,
+                           uint32_t *count, uint32_t *ms );
+/**
+ * @brief   Returns the mean wind speed over the last completed buckets
+ *          of a rollup level
+ * @param   level - The bucket size
+ * @param   buckets - The buckets to cover
+ * @retval  The mean wind speed in hundredths of a MPH, 0 if there is no
+ *          data
+ */
+uint32_t getWindSpeedMean_cMPH( weatherRollupLevel_t level, uint16_t buckets );
+/**
+ * @brief   Returns the mean wind speed over the last completed buckets
+ *          of a rollup level in WIND_SPEED_UNIT
+ * @param   level - The bucket size
+ * @param   buckets - The buckets to cover
+ * @retval  The mean wind speed in hundredths of WIND_SPEED_UNIT, or the
+ *          Beaufort force, 0 if there is no data
+ */
+uint32_t getWindSpeedMean_Unit( weatherRollupLevel_t level, uint16_t buckets );
+/**
+ * @brief   Returns the vector mean wind direction over the last completed
+ *          buckets of a rollup level
+ * @param   level - The bucket size
+ * @param   buckets - The buckets to cover
+ * @param   direction - A pointer to store the mean direction, in tenths
+ *          of a degree clockwise from N
+ * @param   steadiness - A pointer to store the length of the mean vector
+ *          in thousandths, 1000 when the vane didn't move.  May be NULL
+ * @retval  0 on success, 1 on failure or if no bucket completed yet
+ */
+int8_t getWindDirRollup( weatherRollupLevel_t level, uint16_t buckets,
+                         uint16_t *direction, uint16_t *steadiness );
+/**
+ * @brief   Returns the rain bucket tips over the last completed buckets
+ *          of a rollup level, minutes or longer
+ * @param   level - The bucket size
+ * @param   buckets - The buckets to cover
+ * @param   tips - A pointer to store the tips
+ * @retval  0 on success, 1 on failure or if no bucket completed yet
+ */
+int8_t getRainRollup( weatherRollupLevel_t level, uint16_t buckets, uint32_t *tips );
+/**
+ * @brief   Returns the rain over the last completed buckets of a rollup
+ *          level, e.g. 60 minutes or 24 hours
+ * @param   level - The bucket size, minutes or longer
+ * @param   buckets - The buckets to cover
+ * @retval  The rain in thousandths of an inch, 0 if there is no data
+ */
+uint32_t getRainTotal_milliIn( weatherRollupLevel_t level, uint16_t buckets );
+/**
+ * @brief   Returns the rain over the last completed buckets of a rollup
+ *          level in RAIN_UNIT
+ * @param   level - The bucket size, minutes or longer
+ * @param   buckets - The buckets to cover
+ * @retval  The rain in thousandths of RAIN_UNIT, 0 if there is no data
+ */
+uint32_t getRainTotal_Unit( weatherRollupLevel_t level, uint16_t buckets );
+#if WEATHER_METER_USE_DOUBLE
+/**
+ * @brief   Returns the mean wind speed over the last completed buckets
+ *          of a rollup level
+ * @param   level - The bucket size
+ * @param   buckets - The buckets to cover
+ * @retval  The mean wind speed in MPH, 0 if there is no data
+ */
+double getWindSpeedMean_MPH( weatherRollupLevel_t level, uint16_t buckets );
+/**
+ * @brief   Returns the rain over the last completed buckets of a rollup
+ *          level, e.g. 60 minutes or 24 hours
+ * @param   level - The bucket size, minutes or longer
+ * @param   buckets - The buckets to cover
+ * @retval  The rain in inches, 0 if there is no data
+ */
+double getRainTotal_in( weatherRollupLevel_t level, uint16_t buckets );
+#endif /* WEATHER_METER_USE_DOUBLE */
+#endif /* WEATHER_ROLLUP */
+
+#if WEATHER_METER_EVENTS
+/**
+ * @brief   Takes the oldest event out of the queues
+ * @param   event - A pointer to store the event
+ * @retval  1 if there was an event, 0 if the queues are empty
+ */
+uint8_t popWeatherEvent( weatherEvent_t *event );
+/**
+ * @brief   Takes up to max events out of the queues, oldest first
+ * @param   events - An array to store the events
+ * @param   max - The size of the array
+ * @retval  The number of events stored
+ */
+uint32_t drainWeatherEvents( weatherEvent_t *events, uint32_t max );
+/**
+ * @brief   Returns the number of events dropped because a queue was full
+ * @param   None
+ * @retval  The number of events dropped
+ */
+uint32_t getWeatherEventDrops( void );
+#endif /* WEATHER_METER_EVENTS */
+
+#if WEATHER_METER_HEALTH
+/**
+ * @brief   Tells the library the DMA has filled a wind vane buffer (or
+ *          half of it with WIND_VANE_DOUBLE_BUFFER), when processing it
+ *          is left to the main loop.  Call it from the HAL callback, the
+ *          buffers completed more than once before processWindVane()
+ *          runs count as overruns.  Without it only a half processed
+ *          twice in a row is seen.  Not needed with WIND_VANE_HAL_CALLBACKS
+ * @param   None
+ * @retval  None
+ */
+void windVaneBufferDone( void );
+/**
+ * @brief   Copies the health counters.  Each counter is a word written
+ *          from one context, so each is read atomically without blocking
+ *          the interrupts
+ * @param   health - Where to put the counters
+ * @retval  0 on success, 1 on failure
+ */
+int8_t getWeatherMeterHealth( weatherMeterHealth_t *health );
+#endif /* WEATHER_METER_HEALTH */
+
+#if WEATHER_METER_SNAPSHOT
+/**
+ * @brief   Returns the readings of the station from one generation, the
+ *          wind vane, wind speed and rain readings all as they were
+ *          between two process calls.  Never blocks the process
+ *          functions, it is retried if one of them published meanwhile,
+ *          so don't call it from an interrupt that can preempt them
+ * @param   snapshot - Where to put the readings
+ * @retval  0 on success, 1 on failure
+ */
+int8_t getStationSnapshot( stationSnapshot_t *snapshot );
+#endif /* WEATHER_METER_SNAPSHOT */
+
+#if WEATHER_METER_PROFILE
+/**
+ * @brief   Starts the profile clock, the DWT cycle counter on cores that
+ *          have one and HAL_GetTick() otherwise, and clears the times
+ * @param   None
+ * @retval  0 on success, 1 on failure
+ */
+int8_t initWeatherProfile( void );
+/**
+ * @brief   Sets the clock the functions are timed with, e.g. a cycle
+ *          counter on the host.  Clears the times
+ * @param   clock - The clock, counting up and wrapping at 2^32
+ * @param   hz - The clock rate
+ * @retval  0 on success, 1 on failure
+ */
+int8_t setWeatherProfileClock( weatherMeterClock_t clock, uint32_t hz );
+/**
+ * @brief   Returns the times of a function, of all stations together.
+ *          Never blocks the functions being timed, the copy is retried
+ *          if one of them finished meanwhile.  The times are added with
+ *          interrupts masked for a few instructions, so a function can be
+ *          timed from any context.  Only calls made by the application
+ *          are timed, the library classifies internally without them
+ * @param   id - The function
+ * @param   profile - Where to put the times
+ * @retval  0 on success, 1 on failure
+ */
+int8_t getWeatherProfile( weatherProfileId_t id, weatherProfile_t *profile );
+/**
+ * @brief   Clears the times of all functions
+ * @param   None
+ * @retval  None
+ */
+void resetWeatherProfile( void );
+#endif /* WEATHER_METER_PROFILE */
+
+/*
+ * The functions below work like the function of the same name without
+ * the wm prefix, on the station wm instead of the default one.  Each
+ * station is independent, the process functions of one station follow
+ * the same context rules as the default one.  The HAL callbacks defined
+ * with WIND_VANE_HAL_CALLBACKS only serve the default station, call
+ * wmProcessWindVaneFirstHalf() / wmProcessWindVaneSecondHalf() for the
+ * others
+ */
+int8_t wmSetWeatherMeterClock( weatherMeter_t *wm, weatherMeterClock_t clock, uint32_t hz );
+
+int8_t wmInitWindVane( weatherMeter_t *wm, ADC_HandleTypeDef *hadc );
+void wmProcessWindVane( weatherMeter_t *wm );
+#if WIND_VANE_DOUBLE_BUFFER
+void wmProcessWindVaneFirstHalf( weatherMeter_t *wm );
+void wmProcessWindVaneSecondHalf( weatherMeter_t *wm );
+#endif /* WIND_VANE_DOUBLE_BUFFER */
+windVaneDir_t wmGetWindVaneDirection( weatherMeter_t *wm );
+int8_t wmSetWindVaneTables( weatherMeter_t *wm, const uint32_t *values, const uint8_t *lut );
+#if WIND_VANE_USE_LUT && !WIND_VANE_EXTERNAL_TABLES
+void wmBuildWindVaneLut( weatherMeter_t *wm );
+#endif /* WIND_VANE_USE_LUT && !WIND_VANE_EXTERNAL_TABLES */
+#if WIND_VANE_DEBOUNCE
+windVaneDir_t wmGetWindVaneDirectionDebounced( weatherMeter_t *wm );
+uint32_t wmGetWindVaneDirChangeCount( weatherMeter_t *wm );
+uint8_t wmGetWindVaneDirChanged( weatherMeter_t *wm );
+#endif /* WIND_VANE_DEBOUNCE */
+#if WIND_VANE_VOTE
+windVaneDir_t wmGetWindVaneVoteDirection( weatherMeter_t *wm, uint8_t *share );
+#endif /* WIND_VANE_VOTE */
+#if WIND_VANE_VECTOR_AVG
+int8_t wmGetWindVaneMeanDirection( weatherMeter_t *wm, windVaneWindow_t window,
+                                   uint16_t *direction, uint16_t *steadiness );
+#endif /* WIND_VANE_VECTOR_AVG */
+const uint32_t* wmGetWindVaneValues( weatherMeter_t *wm );
+#if WIND_VANE_AUTOCAL
+void wmResetWindVaneAutoCal( weatherMeter_t *wm );
+#endif /* WIND_VANE_AUTOCAL */
+
+#if WIND_SPEED_CAPTURE
+int8_t wmInitWindSpeedCapture( weatherMeter_t *wm, TIM_HandleTypeDef *htim, uint32_t channel );
+uint32_t wmGetWindSpeedPeriod( weatherMeter_t *wm );
+#else
+int8_t wmInitWindSpeed( weatherMeter_t *wm, TIM_HandleTypeDef *htim );
+#endif /* WIND_SPEED_CAPTURE */
+void wmProcessWindSpeed( weatherMeter_t *wm );
+uint32_t wmGetWindSpeedCount( weatherMeter_t *wm );
+uint32_t wmGetWindSpeed_cMPH( weatherMeter_t *wm );
+uint32_t wmGetWindSpeed_Q16( weatherMeter_t *wm );
+uint32_t wmGetWindSpeed_Unit( weatherMeter_t *wm );
+#if WEATHER_METER_USE_DOUBLE
+double wmGetWindSpeed_MPH( weatherMeter_t *wm );
+#endif
+#if WIND_GUST
+uint32_t wmGetWindGust_cMPH( weatherMeter_t *wm );
+int8_t wmGetWindGustPeak( weatherMeter_t *wm, windGust_t *gust );
+uint32_t wmGetWindGustPeak_cMPH( weatherMeter_t *wm );
+uint32_t wmGetWindGust_Unit( weatherMeter_t *wm );
+uint32_t wmGetWindGustPeak_Unit( weatherMeter_t *wm );
+#if WEATHER_METER_USE_DOUBLE
+double wmGetWindGust_MPH( weatherMeter_t *wm );
+double wmGetWindGustPeak_MPH( weatherMeter_t *wm );
+#endif /* WEATHER_METER_USE_DOUBLE */
+#endif /* WIND_GUST */
+
+#if RAIN_BUCKET_TIPS
+int8_t wmInitRainBucketTips( weatherMeter_t *wm );
+void wmRainBucketTip( weatherMeter_t *wm );
+uint32_t wmGetRainBucketTips( weatherMeter_t *wm );
+#else
+int8_t wmInitRainBucket( weatherMeter_t *wm, TIM_HandleTypeDef *htim );
+#endif /* RAIN_BUCKET_TIPS */
+void wmProcessRainBucket( weatherMeter_t *wm );
+uint32_t wmGetRainfall_milliInPerHr( weatherMeter_t *wm );
+uint32_t wmGetRainfall_Unit( weatherMeter_t *wm );
+#if WEATHER_METER_USE_DOUBLE
+double wmGetRainfall_inperhr( weatherMeter_t *wm );
+#endif
+#if RAIN_TOTALS
+int8_t wmGetRainTotals( weatherMeter_t *wm, rainTotals_t *totals );
+void wmResetRainDay( weatherMeter_t *wm );
+void wmSetRainDayHook( weatherMeter_t *wm, rainDayHook_t hook );
+#endif /* RAIN_TOTALS */
+
+#if WEATHER_ROLLUP
+int8_t wmGetWindSpeedRollup( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets,
+                             uint32_t *count, uint32_t *ms );
+uint32_t wmGetWindSpeedMean_cMPH( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets );
+uint32_t wmGetWindSpeedMean_Unit( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets );
+int8_t wmGetWindDirRollup( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets,
+                           uint16_t *direction, uint16_t *steadiness );
+int8_t wmGetRainRollup( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets, uint32_t *tips );
+uint32_t wmGetRainTotal_milliIn( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets );
+uint32_t wmGetRainTotal_Unit( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets );
+#if WEATHER_METER_USE_DOUBLE
+double wmGetWindSpeedMean_MPH( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets );
+double wmGetRainTotal_in( weatherMeter_t *wm, weatherRollupLevel_t level, uint16_t buckets );
+#endif /* WEATHER_METER_USE_DOUBLE */
+#endif /* WEATHER_ROLLUP */
+
+#if WEATHER_METER_EVENTS
+uint8_t wmPopWeatherEvent( weatherMeter_t *wm, weatherEvent_t *event );
+uint32_t wmDrainWeatherEvents( weatherMeter_t *wm, weatherEvent_t *events, uint32_t max );
+uint32_t wmGetWeatherEventDrops( weatherMeter_t *wm );
+#endif /* WEATHER_METER_EVENTS */
+
+#if WEATHER_METER_HEALTH
+void wmWindVaneBufferDone( weatherMeter_t *wm );
+int8_t wmGetWeatherMeterHealth( weatherMeter_t *wm, weatherMeterHealth_t *health );
+#endif /* WEATHER_METER_HEALTH */
+
+#if WEATHER_METER_SNAPSHOT
+int8_t wmGetStationSnapshot( weatherMeter_t *wm, stationSnapshot_t *snapshot );
+#endif /* WEATHER_METER_SNAPSHOT */
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,224 @@
+/** @file weatherMeterTables.hpp
+*
+* @brief    Compile time generation of the wind vane tables from the
+*           resistor network of the Sparkfun Weather Meters
+*           (https://www.sparkfun.com/products/8942)
+*
+* @par
+* 	 COPYRIGHT NOTICE: (c) 2018 Andy Josephson
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef _weatherMeterTables_HPP
+#define _weatherMeterTables_HPP
+
+#if !defined( __cplusplus ) || ( __cplusplus < 201402L )
+#error "weatherMeterTables.hpp needs C++14 or later"
+#endif
+
+#include <stdint.h>
+#include "weatherMeter.h"
+
+/*
+ * Usage, from any C++ file of the application:
+ *
+ *  // 4.7k pull-up to 3.3V, ADC reference 3.3V, 12 bit ADC
+ *  typedef windVaneTables< sparkfunVane< 4700, 3300, 3300, 12 > > vaneTables;
+ *  ...
+ *  vaneTables::install();
+ *  initWindVane( &hadc1 );
+ *
+ * Both tables are constexpr so they end up in flash, nothing is computed
+ * at run time.  Compilation fails if any two direction bands overlap for
+ * WIND_VANE_CODE_BAND, e.g. a 10k pull-up puts E and ENE only 37 codes
+ * apart on a 12 bit ADC.
+ */
+
+/**
+ * @brief   The Sparkfun wind vane.  The vane switches one resistor to
+ *          ground per direction, which forms a divider with a pull-up
+ *          to the supply.  Describe another vane with the same members.
+ * @param   PullUpOhms - The pull-up resistor
+ * @param   SupplyMilliVolts - The voltage the pull-up goes to
+ * @param   VrefMilliVolts - The ADC reference voltage
+ * @param   AdcBits - The resolution of the ADC
+ */
+template< uint32_t PullUpOhms,
+          uint32_t SupplyMilliVolts,
+          uint32_t VrefMilliVolts = SupplyMilliVolts,
+          uint32_t AdcBits = WIND_VANE_ADC_BITS >
+struct sparkfunVane
+{
+    static constexpr uint32_t pullUpOhms = PullUpOhms;
+    static constexpr uint32_t supplyMilliVolts = SupplyMilliVolts;
+    static constexpr uint32_t vrefMilliVolts = VrefMilliVolts;
+    static constexpr uint32_t adcBits = AdcBits;
+
+    /**
+     * @brief   The resistance switched in for a direction, from the
+     *          datasheet
+     * @param   dir - The direction, as windVaneDir_t
+     * @retval  The resistance in ohms
+     */
+    static constexpr uint32_t resistance( uint32_t dir )
+    {
+        const uint32_t ohms[WIND_VANE_DIRECTIONS_COUNT] = { 33000,  // N
+                                                            6570,   // NNE
+                                                            8200,   // NE
+                                                            891,    // ENE
+                                                            1000,   // E
+                                                            688,    // ESE
+                                                            2200,   // SE
+                                                            1410,   // SSE
+                                                            3900,   // S
+                                                            3140,   // SSW
+                                                            16000,  // SW
+                                                            14120,  // WSW
+                                                            120000, // W
+                                                            42120,  // WNW
+                                                            64900,  // NW
+                                                            21880 };// NNW
+        return ohms[dir];
+    }
+};
+
+/**
+ * @brief   The wind vane values and lookup tables for a vane circuit.
+ *          Vane is a description of the circuit like sparkfunVane.
+ */
+template< typename Vane >
+struct windVaneTables
+{
+    /**
+     * @brief   The highest ADC code
+     */
+    static constexpr uint32_t maxCode = ( 1UL << Vane::adcBits ) - 1;
+    /**
+     * @brief   The size in bytes of the lookup table, two codes per byte
+     */
+    static constexpr uint32_t lutSize = ( 1UL << Vane::adcBits ) / 2;
+
+    struct valuesTable
+    {
+        uint32_t v[WIND_VANE_DIRECTIONS_COUNT];
+    };
+    struct lutTable
+    {
+        uint8_t v[lutSize];
+    };
+
+    /**
+     * @brief   The ADC code a direction reads as, rounded to nearest
+     * @param   dir - The direction, as windVaneDir_t
+     * @retval  The ADC code
+     */
+    static constexpr uint32_t code( uint32_t dir )
+    {
+        const uint64_t r = Vane::resistance( dir );
+        const uint64_t num = r * Vane::supplyMilliVolts * maxCode;
+        const uint64_t den = ( r + Vane::pullUpOhms ) * Vane::vrefMilliVolts;
+        const uint64_t c = ( num + den / 2 ) / den;
+
+        // Anything above the reference saturates the ADC
+        return( ( c > maxCode ) ? maxCode : (uint32_t)c );
+    }
+
+    /**
+     * @brief   Checks that no code falls in the band of two directions
+     * @param   None
+     * @retval  true if the bands are all disjoint
+     */
+    static constexpr bool bandsDisjoint( void )
+    {
+        for( uint32_t i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
+        {
+            for( uint32_t j=i+1; j<WIND_VANE_DIRECTIONS_COUNT; j++ )
+            {
+                const uint32_t a = code( i );
+                const uint32_t b = code( j );
+
+                if( ( ( a > b ) ? ( a - b ) : ( b - a ) ) <= 2 * WIND_VANE_CODE_BAND )
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static constexpr valuesTable makeValues( void )
+    {
+        valuesTable t = {};
+
+        for( uint32_t i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
+        {
+            t.v[i] = code( i );
+        }
+        return t;
+    }
+
+    static constexpr lutTable makeLut( void )
+    {
+        lutTable t = {};
+
+        // Same layout as buildWindVaneLut(), the even code in the low
+        // nibble and 0 for codes outside every band.  The bands are
+        // disjoint so each code is written at most once
+        for( uint32_t i=0; i<WIND_VANE_DIRECTIONS_COUNT; i++ )
+        {
+            const uint32_t c = code( i );
+            const uint32_t lo = ( c > WIND_VANE_CODE_BAND ) ? ( c - WIND_VANE_CODE_BAND ) : 0;
+            const uint32_t hi = ( c + WIND_VANE_CODE_BAND > maxCode ) ? maxCode : ( c + WIND_VANE_CODE_BAND );
+
+            for( uint32_t k=lo; k<=hi; k++ )
+            {
+                t.v[k >> 1] = (uint8_t)( t.v[k >> 1] | ( i << ( ( k & 1 ) << 2 ) ) );
+            }
+        }
+        return t;
+    }
+
+    static_assert( Vane::adcBits == WIND_VANE_ADC_BITS,
+                   "The vane ADC resolution must match WIND_VANE_ADC_BITS" );
+    static_assert( bandsDisjoint(),
+                   "Wind vane bands overlap, reduce the code band or change the pull-up" );
+
+    /**
+     * @brief   The ADC value of each direction, in the format of
+     *          WIND_VANE_VALUES
+     */
+    static constexpr valuesTable values = makeValues();
+    /**
+     * @brief   The lookup table, in the format built by buildWindVaneLut()
+     */
+    static constexpr lutTable lut = makeLut();
+
+    /**
+     * @brief   Hands both tables to the library
+     * @param   None
+     * @retval  0 on success, 1 on failure
+     */
+    static int8_t install( void )
+    {
+        return setWindVaneTables( values.v, lut.v );
+    }
+};
+
+template< typename Vane >
+constexpr typename windVaneTables< Vane >::valuesTable windVaneTables< Vane >::values;
+template< typename Vane >
+constexpr typename windVaneTables< Vane >::lutTable windVaneTables< Vane >::lut;
+
+#endif /* _weatherMeterTables_HPP */